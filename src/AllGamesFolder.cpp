@@ -0,0 +1,204 @@
+#include "AllGamesFolder.h"
+#include "SystemData.h"
+#include <algorithm>
+#include <queue>
+
+AllGamesFolder::AllGamesFolder(const std::vector<SystemData*>& systems)
+	: FolderData(NULL, "all", "All Games")
+{
+	mSources.resize(systems.size());
+	for(unsigned int i = 0; i < systems.size(); i++)
+	{
+		mSources[i].system = systems[i];
+		loadSource(mSources[i]);
+	}
+}
+
+void AllGamesFolder::loadSource(Source& source)
+{
+	source.keys.clear();
+	source.indices.clear();
+	source.runs.clear();
+
+	Source* s = &source;
+	source.system->getRootFolder()->visitGames([s](GameData* game) {
+		s->indices[game] = s->keys.size();
+		s->keys.push_back(makeSortKey(game));
+	});
+
+	source.gamesVersion = source.system->getGamesVersion();
+}
+
+void AllGamesFolder::refresh()
+{
+	//only systems whose games were added, removed or changed are loaded again
+	for(auto it = mSources.begin(); it != mSources.end(); it++)
+	{
+		if(it->gamesVersion != it->system->getGamesVersion() || !std::all_of(it->keys.begin(), it->keys.end(), isCurrent))
+		{
+			loadSource(*it);
+			mMerged.clear();
+		}
+	}
+}
+
+const std::vector<unsigned int>& AllGamesFolder::getRun(Source& source, const State& state)
+{
+	auto run = source.runs.find(state);
+	if(run != source.runs.end())
+		return run->second;
+
+	std::vector<unsigned int> order(source.keys.size());
+	for(unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	SortKeyComparison* comparison = getSortKeyComparison(*state.first);
+	bool ascending = state.second;
+	const std::vector<SortKey>& keys = source.keys;
+	std::sort(order.begin(), order.end(), [comparison, ascending, &keys](unsigned int a, unsigned int b) {
+		return ascending ? comparison(keys[a], keys[b]) : comparison(keys[b], keys[a]);
+	});
+
+	return source.runs.insert(std::make_pair(state, order)).first->second;
+}
+
+bool AllGamesFolder::isBefore(const State& state, const Entry& a, const Entry& b) const
+{
+	SortKeyComparison* comparison = getSortKeyComparison(*state.first);
+	const SortKey& keyA = mSources[a.source].keys[a.index];
+	const SortKey& keyB = mSources[b.source].keys[b.index];
+	return state.second ? comparison(keyA, keyB) : comparison(keyB, keyA);
+}
+
+void AllGamesFolder::merge(const State& state, std::vector<Entry>& merged)
+{
+	//the head of every run goes into a heap, the smallest one is taken and replaced by the next of its run
+	std::vector<const std::vector<unsigned int>*> runs;
+	size_t total = 0;
+	for(unsigned int i = 0; i < mSources.size(); i++)
+	{
+		runs.push_back(&getRun(mSources[i], state));
+		total += runs.back()->size();
+	}
+
+	struct Head
+	{
+		Entry entry;
+		unsigned int position;
+	};
+
+	//priority_queue puts the largest first
+	auto after = [this, &state](const Head& a, const Head& b) { return isBefore(state, b.entry, a.entry); };
+	std::priority_queue<Head, std::vector<Head>, decltype(after)> heads(after);
+	for(unsigned int i = 0; i < runs.size(); i++)
+	{
+		if(!runs[i]->empty())
+		{
+			Head head = { { i, runs[i]->front() }, 0 };
+			heads.push(head);
+		}
+	}
+
+	merged.clear();
+	merged.reserve(total);
+	while(!heads.empty())
+	{
+		Head head = heads.top();
+		heads.pop();
+		merged.push_back(head.entry);
+
+		const std::vector<unsigned int>& run = *runs[head.entry.source];
+		if(++head.position < run.size())
+		{
+			head.entry.index = run[head.position];
+			heads.push(head);
+		}
+	}
+}
+
+void AllGamesFolder::sort(ComparisonFunction & comparisonFunction, bool ascending)
+{
+	//every sort state the game list offers has a key comparison, anything else sorts by name
+	ComparisonFunction* function = &comparisonFunction;
+	if(getSortKeyComparison(comparisonFunction) == NULL)
+		function = &compareFileName;
+
+	refresh();
+
+	State state(function, ascending);
+	auto merged = mMerged.find(state);
+	if(merged == mMerged.end())
+	{
+		merged = mMerged.insert(std::make_pair(state, std::vector<Entry>())).first;
+		merge(state, merged->second);
+	}
+
+	std::vector<FileData*> files;
+	files.reserve(merged->second.size());
+	for(auto it = merged->second.begin(); it != merged->second.end(); it++)
+		files.push_back(mSources[it->source].keys[it->index].file);
+
+	setFiles(files);
+}
+
+SystemData* AllGamesFolder::getSystem(GameData* game) const
+{
+	for(auto it = mSources.begin(); it != mSources.end(); it++)
+	{
+		if(it->indices.find(game) != it->indices.end())
+			return it->system;
+	}
+
+	return NULL;
+}
+
+void AllGamesFolder::updateGame(GameData* game, unsigned int generationBefore)
+{
+	for(unsigned int s = 0; s < mSources.size(); s++)
+	{
+		Source& source = mSources[s];
+		auto found = source.indices.find(game);
+		if(found == source.indices.end())
+			continue;
+
+		if(source.gamesVersion != source.system->getGamesVersion())
+			return;
+
+		//the game changed before as well, the next sort loads its system again anyway
+		unsigned int index = found->second;
+		if(source.keys[index].generation != generationBefore)
+			return;
+
+		source.keys[index] = makeSortKey(game);
+
+		//take the game out of every cached order and put it back where its new key belongs
+		for(auto run = source.runs.begin(); run != source.runs.end(); run++)
+		{
+			std::vector<unsigned int>& order = run->second;
+			order.erase(std::find(order.begin(), order.end(), index));
+
+			Entry entry = { s, index };
+			const State& state = run->first;
+			auto position = std::upper_bound(order.begin(), order.end(), entry, [this, &state, s](const Entry& e, unsigned int other) {
+				Entry otherEntry = { s, other };
+				return isBefore(state, e, otherEntry);
+			});
+			order.insert(position, index);
+		}
+
+		for(auto merged = mMerged.begin(); merged != mMerged.end(); merged++)
+		{
+			std::vector<Entry>& order = merged->second;
+			Entry entry = { s, index };
+			order.erase(std::find_if(order.begin(), order.end(), [s, index](const Entry& e) { return e.source == s && e.index == index; }));
+
+			const State& state = merged->first;
+			auto position = std::upper_bound(order.begin(), order.end(), entry, [this, &state](const Entry& a, const Entry& b) {
+				return isBefore(state, a, b);
+			});
+			order.insert(position, entry);
+		}
+
+		return;
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef _ALLGAMESFOLDER_H_
+#define _ALLGAMESFOLDER_H_
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include "FolderData.h"
+
+class SystemData;
+
+//A virtual folder with the games of every system in one flat list. Nothing is copied - the games stay where they are,
+//owned by their systems, and are only referenced from here.
+//Every system's games are sorted on their own (and the result cached per sort state), the list shown is a k-way merge
+//of those runs, so switching the sort order doesn't re-sort the whole library, and a system that changed is the only
+//one sorted again.
+class AllGamesFolder : public FolderData
+{
+public:
+	AllGamesFolder(const std::vector<SystemData*>& systems);
+
+	void sort(ComparisonFunction & comparisonFunction = compareFileName, bool ascending = true) override;
+
+	SystemData* getSystem(GameData* game) const override; //NULL if game isn't in here
+
+	//Call after the metadata of game changed, e.g. by launching it. generationBefore is the game's
+	//MetaDataList::getGeneration() from before the change: if its cached key was up to date with that, game is only moved
+	//to its new place in the cached orders, otherwise the next sort loads its system again.
+	void updateGame(GameData* game, unsigned int generationBefore);
+
+private:
+	typedef std::pair<ComparisonFunction*, bool> State;
+
+	struct Source
+	{
+		SystemData* system;
+		unsigned int gamesVersion; //SystemData::getGamesVersion() the keys were taken at
+		std::vector<SortKey> keys; //one per game
+		std::unordered_map<GameData*, unsigned int> indices; //game -> index in keys
+		std::map<State, std::vector<unsigned int> > runs; //sort state -> indices in keys, sorted
+	};
+
+	struct Entry
+	{
+		unsigned int source;
+		unsigned int index;
+	};
+
+	void refresh();
+	void loadSource(Source& source);
+	const std::vector<unsigned int>& getRun(Source& source, const State& state);
+	void merge(const State& state, std::vector<Entry>& merged);
+	bool isBefore(const State& state, const Entry& a, const Entry& b) const;
+
+	std::vector<Source> mSources;
+	std::map<State, std::vector<Entry> > mMerged; //sort state -> all games, sorted
+};
+
+#endif
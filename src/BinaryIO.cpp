@@ -0,0 +1,100 @@
+#include "BinaryIO.h"
+#include "Log.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+MappedFile::MappedFile() : mData(NULL), mSize(0), mMapped(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifndef WIN32
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(map != MAP_FAILED)
+		{
+			mData = (const char*)map;
+			mSize = (size_t)st.st_size;
+			mMapped = true;
+		}
+	}
+
+	::close(fd);
+	if(mMapped)
+		return true;
+#endif
+
+	//no mmap, read it the boring way
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	mBuffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if(mBuffer.empty())
+		return false;
+
+	mData = mBuffer.data();
+	mSize = mBuffer.size();
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifndef WIN32
+	if(mMapped)
+		munmap((void*)mData, mSize);
+#endif
+
+	mData = NULL;
+	mSize = 0;
+	mMapped = false;
+	mBuffer.clear();
+}
+
+bool writeFileAtomically(const std::string& path, const std::string& data)
+{
+	boost::system::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+
+	std::string tempPath = path + ".tmp";
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open() || !file.write(data.data(), data.size()))
+	{
+		LOG(LogWarning) << "Could not write \"" << tempPath << "\"";
+		return false;
+	}
+	file.close();
+
+	fs::rename(tempPath, path, ec);
+	if(ec)
+	{
+		LOG(LogWarning) << "Could not replace \"" << path << "\": " << ec.message();
+		fs::remove(tempPath, ec);
+		return false;
+	}
+
+	return true;
+}
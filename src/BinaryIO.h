@@ -0,0 +1,109 @@
+#ifndef _BINARYIO_H_
+#define _BINARYIO_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+//Helpers for the little binary caches we keep next to our config files.
+//Values are stored in native byte order - the caches are never shared between machines, a version check is enough.
+
+template<typename T>
+void writeBinaryValue(std::string& out, T value)
+{
+	out.append((const char*)&value, sizeof(T));
+}
+
+inline void writeBinaryString(std::string& out, const std::string& str)
+{
+	writeBinaryValue<uint32_t>(out, (uint32_t)str.size());
+	out.append(str);
+}
+
+//Bounds-checked reader over a block of memory. Once anything went wrong, every read fails and ok() returns false.
+class BinaryReader
+{
+public:
+	BinaryReader(const char* data, size_t size) : mData(data), mSize(size), mPos(0), mOk(true) {}
+
+	template<typename T>
+	T read()
+	{
+		T value = T();
+		if(mOk && mPos + sizeof(T) <= mSize)
+		{
+			memcpy(&value, mData + mPos, sizeof(T));
+			mPos += sizeof(T);
+		}else{
+			mOk = false;
+		}
+		return value;
+	}
+
+	std::string readString()
+	{
+		uint32_t size = read<uint32_t>();
+		if(!mOk || size > mSize - mPos)
+		{
+			mOk = false;
+			return "";
+		}
+
+		std::string str(mData + mPos, size);
+		mPos += size;
+		return str;
+	}
+
+	//compares the next bytes with a magic number and skips them
+	bool readMagic(const char* magic, size_t size)
+	{
+		if(!mOk || size > mSize - mPos || memcmp(mData + mPos, magic, size) != 0)
+		{
+			mOk = false;
+			return false;
+		}
+
+		mPos += size;
+		return true;
+	}
+
+	bool ok() const { return mOk; }
+	bool atEnd() const { return mPos == mSize; }
+
+private:
+	const char* mData;
+	size_t mSize;
+	size_t mPos;
+	bool mOk;
+};
+
+//A whole file in memory, read-only. Uses mmap where available, so nothing is copied until the data is used.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	//Returns false if the file can't be opened (or is empty).
+	bool open(const std::string& path);
+	void close();
+
+	const char* data() const { return mData; }
+	size_t size() const { return mSize; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const char* mData;
+	size_t mSize;
+	bool mMapped;
+	std::vector<char> mBuffer; //used if the file couldn't be mapped
+};
+
+//Writes data to a temporary file and renames it over path, so a crash can't leave a half-written file behind.
+//The parent directory is created if necessary. Returns false (and logs a warning) on errors.
+bool writeFileAtomically(const std::string& path, const std::string& data);
+
+#endif
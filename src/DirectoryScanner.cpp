@@ -0,0 +1,284 @@
+#include "DirectoryScanner.h"
+#include "Log.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#ifndef WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+	typedef ScanCache::RawEntry RawEntry;
+	typedef ScanCache::EntryType EntryType;
+
+	//reads the names (and types, if the filesystem tells us for free) of everything in a directory
+	bool readDirectory(const std::string& path, std::vector<RawEntry>& entries)
+	{
+#ifdef WIN32
+		boost::system::error_code ec;
+		for(fs::directory_iterator end, dir(path, ec); !ec && dir != end; dir.increment(ec))
+		{
+			RawEntry entry = { dir->path().filename().string(), ScanCache::ENTRY_UNKNOWN };
+			entries.push_back(entry);
+		}
+		return !ec;
+#else
+		DIR* dir = opendir(path.c_str());
+		if(dir == NULL)
+			return false;
+
+		//glibc's readdir fetches entries in large getdents64 batches
+		struct dirent* ent;
+		while((ent = readdir(dir)) != NULL)
+		{
+			if(strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+				continue;
+
+			RawEntry entry = { ent->d_name, ScanCache::ENTRY_UNKNOWN };
+#ifdef _DIRENT_HAVE_D_TYPE
+			switch(ent->d_type)
+			{
+			case DT_DIR: entry.type = ScanCache::ENTRY_DIRECTORY; break;
+			case DT_LNK: entry.type = ScanCache::ENTRY_SYMLINK; break;
+			case DT_UNKNOWN: entry.type = ScanCache::ENTRY_UNKNOWN; break;
+			default: entry.type = ScanCache::ENTRY_FILE; break;
+			}
+#endif
+			entries.push_back(entry);
+		}
+
+		closedir(dir);
+		return true;
+#endif
+	}
+
+	//resolves the entry type if readDirectory couldn't (type is updated); isDirectory follows symlinks like fs::is_directory does
+	void classifyEntry(const std::string& path, EntryType& type, bool& isDirectory, bool& isSymlink)
+	{
+#ifdef WIN32
+		boost::system::error_code ec;
+		isDirectory = fs::is_directory(path, ec);
+		isSymlink = isDirectory && fs::is_symlink(path, ec);
+#else
+		struct stat st;
+		if(type == ScanCache::ENTRY_UNKNOWN)
+		{
+			if(lstat(path.c_str(), &st) != 0)
+			{
+				isDirectory = isSymlink = false;
+				return;
+			}
+			type = S_ISLNK(st.st_mode) ? ScanCache::ENTRY_SYMLINK : (S_ISDIR(st.st_mode) ? ScanCache::ENTRY_DIRECTORY : ScanCache::ENTRY_FILE);
+		}
+
+		isSymlink = (type == ScanCache::ENTRY_SYMLINK);
+		if(isSymlink)
+			isDirectory = (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+		else
+			isDirectory = (type == ScanCache::ENTRY_DIRECTORY);
+#endif
+	}
+}
+
+DirectoryScanner::DirectoryScanner(const std::vector<std::string>& extensions, unsigned int threadCount, ScanCache* cache)
+	: mExtensions(extensions), mCache(cache), mPendingTasks(0)
+{
+	if(threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if(threadCount == 0)
+		threadCount = 1;
+
+	for(unsigned int i = 0; i < threadCount; i++)
+		mQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+}
+
+void DirectoryScanner::Directory::collectPaths(std::vector<std::string>& paths) const
+{
+	paths.push_back(path);
+	for(auto it = entries.begin(); it != entries.end(); it++)
+	{
+		if(it->directory)
+			it->directory->collectPaths(paths);
+	}
+}
+
+std::string DirectoryScanner::joinPath(const std::string& directory, const std::string& name)
+{
+	if(directory.empty() || directory[directory.length() - 1] == '/')
+		return directory + name;
+
+	return directory + "/" + name;
+}
+
+bool DirectoryScanner::isRecursiveSymlink(const std::string& path)
+{
+	//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
+	boost::system::error_code ec;
+	fs::path canonical = fs::canonical(path, ec);
+	return !ec && path.find(canonical.generic_string()) == 0;
+}
+
+std::unique_ptr<DirectoryScanner::Directory> DirectoryScanner::scan(const std::string& path)
+{
+	std::unique_ptr<Directory> root;
+
+	boost::system::error_code ec;
+	if(!fs::is_directory(path, ec))
+	{
+		LOG(LogWarning) << "Error - folder with path \"" << path << "\" is not a directory!";
+		return root;
+	}
+
+	//make sure that this isn't a symlink to a thing we already have
+	if(fs::is_symlink(path, ec) && isRecursiveSymlink(path))
+	{
+		LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << path << "\"";
+		return root;
+	}
+
+	root.reset(new Directory());
+	root->path = path;
+
+	pushTask(0, root.get());
+
+	//the calling thread is worker 0
+	std::vector<std::thread> helpers;
+	for(unsigned int i = 1; i < mQueues.size(); i++)
+		helpers.push_back(std::thread(&DirectoryScanner::work, this, i));
+	work(0);
+	for(auto it = helpers.begin(); it != helpers.end(); it++)
+		it->join();
+
+	return root;
+}
+
+void DirectoryScanner::pushTask(unsigned int id, Directory* dir)
+{
+	mPendingTasks++;
+
+	std::lock_guard<std::mutex> lock(mQueues.at(id)->mutex);
+	mQueues.at(id)->tasks.push_back(dir);
+}
+
+DirectoryScanner::Directory* DirectoryScanner::popTask(unsigned int id)
+{
+	//newest task from our own queue first, keeps a thread working depth-first in one part of the tree
+	{
+		WorkQueue& own = *mQueues.at(id);
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if(!own.tasks.empty())
+		{
+			Directory* dir = own.tasks.back();
+			own.tasks.pop_back();
+			return dir;
+		}
+	}
+
+	//otherwise steal the oldest task of somebody else, which is usually the closest to the root and the biggest
+	for(unsigned int i = 1; i < mQueues.size(); i++)
+	{
+		WorkQueue& victim = *mQueues.at((id + i) % mQueues.size());
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty())
+		{
+			Directory* dir = victim.tasks.front();
+			victim.tasks.pop_front();
+			return dir;
+		}
+	}
+
+	return NULL;
+}
+
+void DirectoryScanner::work(unsigned int id)
+{
+	unsigned int idleRounds = 0;
+
+	//a task only counts as done after its subdirectories were queued, so no pending tasks means the whole tree is done
+	while(mPendingTasks > 0)
+	{
+		Directory* dir = popTask(id);
+		if(dir == NULL)
+		{
+			//somebody is still reading a directory that may give us more work
+			if(++idleRounds < 64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			continue;
+		}
+
+		idleRounds = 0;
+		scanDirectory(id, dir);
+		mPendingTasks--;
+	}
+}
+
+void DirectoryScanner::scanDirectory(unsigned int id, Directory* dir)
+{
+	std::vector<RawEntry> rawEntries;
+
+	//with a cache, one stat tells us if the listing from last time is still good
+	ScanCache::Stamp stamp;
+	bool stamped = mCache != NULL && ScanCache::getStamp(dir->path, stamp);
+	if(!stamped || !mCache->lookup(dir->path, stamp, rawEntries))
+	{
+		if(!readDirectory(dir->path, rawEntries))
+		{
+			LOG(LogWarning) << "Error - could not read directory \"" << dir->path << "\"!";
+			return;
+		}
+	}
+
+	for(auto it = rawEntries.begin(); it != rawEntries.end(); it++)
+	{
+		//these don't touch the filesystem, they only split the name
+		fs::path name(it->name);
+		if(name.stem().string().empty())
+			continue;
+
+		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
+		//we first get the extension of the file itself:
+		std::string extension = name.extension().string();
+
+		Entry entry;
+		entry.name = it->name;
+		entry.isGame = std::find(mExtensions.begin(), mExtensions.end(), extension) != mExtensions.end();
+
+		//add directories that also do not match an extension as folders
+		if(!entry.isGame && it->type != ScanCache::ENTRY_FILE)
+		{
+			std::string path = joinPath(dir->path, it->name);
+
+			bool isDirectory, isSymlink;
+			classifyEntry(path, it->type, isDirectory, isSymlink);
+
+			if(isDirectory)
+			{
+				if(isSymlink && isRecursiveSymlink(path))
+				{
+					LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << path << "\"";
+					continue;
+				}
+
+				entry.directory.reset(new Directory());
+				entry.directory->path = path;
+				pushTask(id, entry.directory.get());
+			}
+		}
+
+		if(entry.isGame || entry.directory)
+			dir->entries.push_back(std::move(entry));
+	}
+
+	//store after classifying, so types we had to stat for are remembered (symlinks always get resolved again)
+	if(stamped)
+		mCache->store(dir->path, stamp, rawEntries);
+}
@@ -0,0 +1,67 @@
+#ifndef _DIRECTORYSCANNER_H_
+#define _DIRECTORYSCANNER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "ScanCache.h"
+
+//Scans a ROM directory tree on several threads at once.
+//Every subdirectory becomes a task on the queue of the thread that found it. Threads work depth-first on their own queue
+//and steal the oldest task of another thread when they run dry, so one huge subfolder can't serialize the whole scan.
+//On POSIX systems the entry type comes from readdir's d_type, so only symlinks and odd filesystems need a stat() per entry.
+class DirectoryScanner
+{
+public:
+	struct Directory;
+
+	struct Entry
+	{
+		std::string name;
+		bool isGame; //the name matches one of the search extensions (this can be a directory too, see issue #75)
+		std::unique_ptr<Directory> directory; //scanned contents, only set for directories that aren't games
+	};
+
+	struct Directory
+	{
+		std::string path; //generic path of this directory
+		std::vector<Entry> entries; //games and subdirectories in directory order, everything else is dropped
+
+		//appends the path of this directory and every directory below it
+		void collectPaths(std::vector<std::string>& paths) const;
+	};
+
+	//threadCount = 0 uses one thread per hardware thread.
+	//If cache is set, unchanged directories are taken from it instead of being read, and every listing is stored back into it.
+	DirectoryScanner(const std::vector<std::string>& extensions, unsigned int threadCount = 0, ScanCache* cache = NULL);
+
+	//Scans the tree at path. Returns an empty pointer if path isn't a directory or is an infinitely recursive symlink.
+	std::unique_ptr<Directory> scan(const std::string& path);
+
+	//Joins a directory path and an entry name the way boost::filesystem::path::operator/ would.
+	static std::string joinPath(const std::string& directory, const std::string& name);
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Directory*> tasks;
+	};
+
+	void work(unsigned int id);
+	Directory* popTask(unsigned int id);
+	void pushTask(unsigned int id, Directory* dir);
+	void scanDirectory(unsigned int id, Directory* dir);
+
+	static bool isRecursiveSymlink(const std::string& path);
+
+	std::vector<std::string> mExtensions;
+	ScanCache* mCache;
+	std::vector< std::unique_ptr<WorkQueue> > mQueues;
+	std::atomic<int> mPendingTasks;
+};
+
+#endif
@@ -17,7 +17,7 @@ public:
         // if isSelected = true => set selection timestamp to now
         virtual void setSelected(bool isSelected) = 0;
 	virtual const std::string& getName() const = 0;
-	virtual const std::string& getPath() const = 0;
+	virtual std::string getPath() const = 0;
 };
 
 #endif
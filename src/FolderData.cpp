@@ -4,35 +4,50 @@
 #include <algorithm>
 #include <iostream>
 
+namespace
+{
+	//true if a1 + a2 < b1 + b2, compared like std::string does without joining them
+	bool isPathLess(const std::string& a1, const std::string& a2, const std::string& b1, const std::string& b2)
+	{
+		const size_t lengthA = a1.size() + a2.size();
+		const size_t lengthB = b1.size() + b2.size();
+		for(size_t i = 0; i < lengthA && i < lengthB; i++)
+		{
+			unsigned char ca = (i < a1.size()) ? a1[i] : a2[i - a1.size()];
+			unsigned char cb = (i < b1.size()) ? b1[i] : b2[i - b1.size()];
+			if(ca != cb)
+				return ca < cb;
+		}
+
+		return lengthA < lengthB;
+	}
+}
 
-std::map<FolderData::ComparisonFunction*, std::string> FolderData::sortStateNameMap;
+//initialized statically, systems (and with them their folders) are created from several threads
+std::map<FolderData::ComparisonFunction*, std::string> FolderData::sortStateNameMap = {
+	{ FolderData::compareFileName, "file name" },
+	{ FolderData::compareRating, "rating" },
+	{ FolderData::compareTimesPlayed, "times played" },
+	{ FolderData::compareLastPlayed, "last time played" }
+};
 
 bool FolderData::isFolder() const { return true; }
 const std::string & FolderData::getName() const { return mName; }
-const std::string & FolderData::getPath() const { return mPath; }
+std::string FolderData::getPath() const { return mPath; }
 unsigned int FolderData::getFileCount() { return mFileVector.size(); }
+unsigned int FolderData::getGameCount() const { return mGameCount; }
+FolderData* FolderData::getParent() const { return mParent; }
+SystemData* FolderData::getSystem(GameData* game) const { return mSystem; }
 
 
 FolderData::FolderData(SystemData* system, std::string path, std::string name)
-	: mSystem(system), mPath(path), mName(name)
-{
-	//first created folder data initializes the list
-	if (sortStateNameMap.empty()) {
-		sortStateNameMap[compareFileName] = "file name";
-		sortStateNameMap[compareRating] = "rating";
-		sortStateNameMap[compareTimesPlayed] = "times played";
-		sortStateNameMap[compareLastPlayed] = "last time played";
-	}
+	: mSortKeysValid(false), mSortedState((ComparisonFunction*)NULL, true), mSystem(system), mParent(NULL), mGameCount(0), mPath(path), mName(name)
+{
 }
 
+//the files are owned by the system's arenas, SystemData::destroyFile() destroys them
 FolderData::~FolderData()
 {
-	for(unsigned int i = 0; i < mFileVector.size(); i++)
-	{
-		delete mFileVector.at(i);
-	}
-
-	mFileVector.clear();
 }
 
 boost::posix_time::ptime FolderData::isSelected() const
@@ -57,9 +72,8 @@ void FolderData::reselect()
         mSelected = boost::date_time::min_date_time;
         for (FileData *file: mFileVector)
         {
-                FolderData *folder = dynamic_cast<FolderData*>(file);
-                if (folder)
-                        folder->reselect();
+                if (file->isFolder())
+                        ((FolderData*)file)->reselect();
                 if (file->isSelected() != boost::date_time::not_a_date_time
                                 && mSelected < file->isSelected())
                         mSelected = file->isSelected();
@@ -69,29 +83,189 @@ void FolderData::reselect()
 void FolderData::pushFileData(FileData* file)
 {
 	mFileVector.push_back(file);
+	invalidateSortCache();
+
+	//keep the lookup tables up to date, games in a pushed folder were already indexed when they were pushed into it
+	if(file->isFolder())
+	{
+		FolderData* folder = (FolderData*)file;
+		folder->mParent = this;
+		mSubfolders[file->getPath()] = folder;
+		addGameCount(folder->mGameCount);
+	}else{
+		mSystem->indexGame((GameData*)file);
+		addGameCount(1);
+	}
 }
 
-//sort this folder and any subfolders
-void FolderData::sort(ComparisonFunction & comparisonFunction, bool ascending)
+void FolderData::addGameCount(int difference)
+{
+	for(FolderData* folder = this; folder != NULL; folder = folder->mParent)
+		folder->mGameCount += difference;
+}
+
+FolderData* FolderData::getSubfolder(const std::string& path) const
+{
+	auto it = mSubfolders.find(path);
+	return it == mSubfolders.end() ? NULL : it->second;
+}
+
+void FolderData::invalidateSortCache()
 {
-	std::sort(mFileVector.begin(), mFileVector.end(), comparisonFunction);
+	mSortKeysValid = false;
+	mSortCache.clear();
+	mSortedState = std::make_pair((ComparisonFunction*)NULL, true);
+}
 
-	for(unsigned int i = 0; i < mFileVector.size(); i++)
+FolderData::SortKey FolderData::makeSortKey(FileData* file)
+{
+	static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	static const std::string noFileName;
+
+	SortKey key = { file, file->getName(), 0, 0, INT64_MIN, 0, NULL, &noFileName };
+	std::transform(key.name.begin(), key.name.end(), key.name.begin(), [](char c) { return (char)toupper((unsigned char)c); });
+
+	if(file->isFolder())
 	{
-		if(mFileVector.at(i)->isFolder())
-			((FolderData*)mFileVector.at(i))->sort(comparisonFunction, ascending);
+		key.directory = &static_cast<FolderData*>(file)->mPath;
+	}else{
+		GameData* game = static_cast<GameData*>(file);
+		key.directory = &game->getDirectory();
+		key.fileName = &game->getFileName();
+
+		MetaDataList* metadata = game->metadata();
+		key.rating = metadata->getFloat(MDF_RATING);
+		key.timesPlayed = metadata->getInt(MDF_PLAYCOUNT);
+
+		boost::posix_time::ptime lastPlayed = metadata->getTime(MDF_LASTPLAYED);
+		if(!lastPlayed.is_special())
+			key.lastPlayed = (lastPlayed - epoch).total_seconds();
+
+		key.generation = metadata->getGeneration();
 	}
 
-	if (!ascending) {
-		std::reverse(mFileVector.begin(), mFileVector.end());
+	return key;
+}
+
+bool FolderData::isCurrent(const SortKey& key)
+{
+	return key.file->isFolder() || static_cast<GameData*>(key.file)->metadata()->getGeneration() == key.generation;
+}
+
+void FolderData::setFiles(const std::vector<FileData*>& files)
+{
+	mFileVector = files;
+	invalidateSortCache();
+}
+
+//ties are broken by name and then path, so the order doesn't depend on the order files were found in
+bool FolderData::compareKeyNames(const SortKey& a, const SortKey& b)
+{
+	//compared as (signed) chars, like compareFileName does
+	if(a.name != b.name)
+		return std::lexicographical_compare(a.name.begin(), a.name.end(), b.name.begin(), b.name.end());
+
+	//games in the same directory share the directory string
+	if(a.directory == b.directory)
+		return *a.fileName < *b.fileName;
+	return isPathLess(*a.directory, *a.fileName, *b.directory, *b.fileName);
+}
+
+bool FolderData::compareKeyRatings(const SortKey& a, const SortKey& b)
+{
+	if(a.rating != b.rating)
+		return a.rating < b.rating;
+	return compareKeyNames(a, b);
+}
+
+bool FolderData::compareKeyTimesPlayed(const SortKey& a, const SortKey& b)
+{
+	if(a.timesPlayed != b.timesPlayed)
+		return a.timesPlayed < b.timesPlayed;
+	return compareKeyNames(a, b);
+}
+
+bool FolderData::compareKeyLastPlayed(const SortKey& a, const SortKey& b)
+{
+	if(a.lastPlayed != b.lastPlayed)
+		return a.lastPlayed < b.lastPlayed;
+	return compareKeyNames(a, b);
+}
+
+FolderData::SortKeyComparison* FolderData::getSortKeyComparison(ComparisonFunction & comparisonFunction)
+{
+	if(&comparisonFunction == &compareFileName)
+		return &compareKeyNames;
+	if(&comparisonFunction == &compareRating)
+		return &compareKeyRatings;
+	if(&comparisonFunction == &compareTimesPlayed)
+		return &compareKeyTimesPlayed;
+	if(&comparisonFunction == &compareLastPlayed)
+		return &compareKeyLastPlayed;
+
+	return NULL;
+}
+
+void FolderData::sort(ComparisonFunction & comparisonFunction, bool ascending)
+{
+	SortKeyComparison* keyComparison = getSortKeyComparison(comparisonFunction);
+	if(keyComparison == NULL)
+	{
+		//not one of ours, nothing to cache
+		invalidateSortCache();
+		std::sort(mFileVector.begin(), mFileVector.end(), comparisonFunction);
+		if (!ascending) {
+			std::reverse(mFileVector.begin(), mFileVector.end());
+		}
+	}else{
+		//only the metadata of this folder's own games matters
+		if(mSortKeysValid && !std::all_of(mSortKeys.begin(), mSortKeys.end(), isCurrent))
+			invalidateSortCache();
+
+		auto state = std::make_pair(&comparisonFunction, ascending);
+		if(mSortKeysValid && mSortedState == state)
+			return;
+
+		auto cached = mSortCache.find(state);
+		if(cached == mSortCache.end())
+		{
+			if(!mSortKeysValid)
+			{
+				mSortKeys.clear();
+				mSortKeys.reserve(mFileVector.size());
+				for(auto it = mFileVector.begin(); it != mFileVector.end(); it++)
+					mSortKeys.push_back(makeSortKey(*it));
+
+				mSortKeysValid = true;
+			}
+
+			std::vector<const SortKey*> order;
+			order.reserve(mSortKeys.size());
+			for(auto it = mSortKeys.begin(); it != mSortKeys.end(); it++)
+				order.push_back(&(*it));
+
+			std::sort(order.begin(), order.end(), [keyComparison, ascending](const SortKey* a, const SortKey* b) {
+				return ascending ? keyComparison(*a, *b) : keyComparison(*b, *a);
+			});
+
+			std::vector<FileData*> files;
+			files.reserve(order.size());
+			for(auto it = order.begin(); it != order.end(); it++)
+				files.push_back((*it)->file);
+
+			cached = mSortCache.insert(std::make_pair(state, files)).first;
+		}
+
+		mFileVector = cached->second;
+		mSortedState = state;
 	}
 }
 
 //returns if file1 should come before file2
 bool FolderData::compareFileName(const FileData* file1, const FileData* file2)
 {
-	std::string name1 = file1->getName();
-	std::string name2 = file2->getName();
+	const std::string& name1 = file1->getName();
+	const std::string& name2 = file2->getName();
 
 	//min of name1/name2 .length()s
 	unsigned int count = name1.length() > name2.length() ? name2.length() : name1.length();
@@ -108,33 +282,27 @@ bool FolderData::compareFileName(const FileData* file1, const FileData* file2)
 
 bool FolderData::compareRating(const FileData* file1, const FileData* file2)
 {
-	//we need game data. try to cast
-	const GameData * game1 = dynamic_cast<const GameData*>(file1);
-	const GameData * game2 = dynamic_cast<const GameData*>(file2);
-	if (game1 != nullptr && game2 != nullptr) {
-		return const_cast<GameData*>(game1)->metadata()->getFloat("rating") < const_cast<GameData*>(game2)->metadata()->getFloat("rating");
+	//only games have a rating
+	if (!file1->isFolder() && !file2->isFolder()) {
+		return const_cast<GameData*>(static_cast<const GameData*>(file1))->metadata()->getFloat(MDF_RATING) < const_cast<GameData*>(static_cast<const GameData*>(file2))->metadata()->getFloat(MDF_RATING);
 	}
 	return false;
 }
 
 bool FolderData::compareTimesPlayed(const FileData* file1, const FileData* file2)
 {
-	//we need game data. try to cast
-	const GameData * game1 = dynamic_cast<const GameData*>(file1);
-	const GameData * game2 = dynamic_cast<const GameData*>(file2);
-	if (game1 != nullptr && game2 != nullptr) {
-		return const_cast<GameData*>(game1)->metadata()->getInt("playcount") < const_cast<GameData*>(game2)->metadata()->getInt("playcount");
+	//only games have a play count
+	if (!file1->isFolder() && !file2->isFolder()) {
+		return const_cast<GameData*>(static_cast<const GameData*>(file1))->metadata()->getInt(MDF_PLAYCOUNT) < const_cast<GameData*>(static_cast<const GameData*>(file2))->metadata()->getInt(MDF_PLAYCOUNT);
 	}
 	return false;
 }
 
 bool FolderData::compareLastPlayed(const FileData* file1, const FileData* file2)
 {
-	//we need game data. try to cast
-	const GameData * game1 = dynamic_cast<const GameData*>(file1);
-	const GameData * game2 = dynamic_cast<const GameData*>(file2);
-	if (game1 != nullptr && game2 != nullptr) {
-		return const_cast<GameData*>(game1)->metadata()->getTime("lastplayed") < const_cast<GameData*>(game2)->metadata()->getTime("lastplayed");
+	//only games have a last played time
+	if (!file1->isFolder() && !file2->isFolder()) {
+		return const_cast<GameData*>(static_cast<const GameData*>(file1))->metadata()->getTime(MDF_LASTPLAYED) < const_cast<GameData*>(static_cast<const GameData*>(file2))->metadata()->getTime(MDF_LASTPLAYED);
 	}
 	return false;
 }
@@ -158,22 +326,14 @@ FileData* FolderData::getFile(unsigned int i) const
 
 std::vector<FileData*> FolderData::getFiles(bool onlyFiles) const
 {
+	if(!onlyFiles)
+		return mFileVector;
+
 	std::vector<FileData*> temp;
-	//now check if a child is a folder and get those children in turn
-	std::vector<FileData*>::const_iterator fdit = mFileVector.cbegin();
-	while(fdit != mFileVector.cend()) {
-		//dynamically try to cast to FolderData type
-		FolderData * folder = dynamic_cast<FolderData*>(*fdit);
-		if (folder != nullptr) {
-			//add this only when user wanted it
-			if (!onlyFiles) {
-				temp.push_back(*fdit);
-			}
-		}
-		else {
-			temp.push_back(*fdit);
-		}
-		++fdit;
+	for(auto it = mFileVector.cbegin(); it != mFileVector.cend(); it++)
+	{
+		if(!(*it)->isFolder())
+			temp.push_back(*it);
 	}
 	return temp;
 }
@@ -181,27 +341,25 @@ std::vector<FileData*> FolderData::getFiles(bool onlyFiles) const
 std::vector<FileData*> FolderData::getFilesRecursive(bool onlyFiles) const
 {
 	std::vector<FileData*> temp;
-	//now check if a child is a folder and get those children in turn
-	std::vector<FileData*>::const_iterator fdit = mFileVector.cbegin();
-	while(fdit != mFileVector.cend()) {
-		//dynamically try to cast to FolderData type
-		FolderData * folder = dynamic_cast<FolderData*>(*fdit);
-		if (folder != nullptr) {
-			//add this onyl when user wanted it
-			if (!onlyFiles) {
-				temp.push_back(*fdit);
-			}
-			//worked. Is actual folder data. recurse
-			std::vector<FileData*> children = folder->getFilesRecursive(onlyFiles);
-			//insert children into return vector
-			temp.insert(temp.end(), children.cbegin(), children.cend());
-		}
-		else {
-			temp.push_back(*fdit);
+	temp.reserve(onlyFiles ? mGameCount : mGameCount + mSubfolders.size());
+	appendFilesRecursive(temp, onlyFiles);
+	return temp;
+}
+
+void FolderData::appendFilesRecursive(std::vector<FileData*>& files, bool onlyFiles) const
+{
+	for(auto it = mFileVector.cbegin(); it != mFileVector.cend(); it++)
+	{
+		if((*it)->isFolder())
+		{
+			//add this only when user wanted it
+			if(!onlyFiles)
+				files.push_back(*it);
+			static_cast<const FolderData*>(*it)->appendFilesRecursive(files, onlyFiles);
+		}else{
+			files.push_back(*it);
 		}
-		++fdit;
 	}
-	return temp;
 }
 
 void FolderData::removeFileRecursive(FileData* f)
@@ -211,15 +369,26 @@ void FolderData::removeFileRecursive(FileData* f)
 	{
 		if(*iter == f)
 		{
-			delete *iter;
+			if(f->isFolder())
+			{
+				mSubfolders.erase(f->getPath());
+
+				FolderData* folder = (FolderData*)f;
+				SystemData* system = mSystem;
+				folder->visitGames([system](GameData* game) { system->unindexGame(game); });
+				addGameCount(-(int)folder->mGameCount);
+			}else{
+				mSystem->unindexGame((GameData*)f);
+				addGameCount(-1);
+			}
+
+			mSystem->destroyFile(*iter);
 			iter = mFileVector.erase(iter);
+			invalidateSortCache();
 		}else{
 			
-			FolderData* folder = dynamic_cast<FolderData*>(*iter);
-			if(folder)
-			{
-				folder->removeFileRecursive(f);
-			}
+			if((*iter)->isFolder())
+				((FolderData*)*iter)->removeFileRecursive(f);
 
 			iter++;
 		}
@@ -3,8 +3,11 @@
 
 #include <map>
 #include <vector>
+#include <unordered_map>
+#include <stdint.h>
 
 #include "FileData.h"
+#include "GameData.h"
 
 
 class SystemData;
@@ -28,24 +31,40 @@ private:
 
 public:
 	FolderData(SystemData* system, std::string path, std::string name);
-	~FolderData();
+	virtual ~FolderData();
 
 	bool isFolder() const;
         boost::posix_time::ptime isSelected() const override;
         void setSelected(bool isSelected) override;
 	const std::string & getName() const;
-	const std::string & getPath() const;
+	std::string getPath() const;
 
 	unsigned int getFileCount();
 	FileData* getFile(unsigned int i) const;
 	std::vector<FileData*> getFiles(bool onlyFiles = false) const;
 	std::vector<FileData*> getFilesRecursive(bool onlyFiles = false) const;
 
+	//Calls visitor(GameData*) for every game in this folder and its subfolders, depth first. Allocates nothing, so
+	//prefer it over getFilesRecursive() when the games are only looked at once.
+	template<typename Visitor>
+	void visitGames(const Visitor& visitor) const;
+
+	//the number of games in this folder and its subfolders, kept up to date as files are pushed and removed
+	unsigned int getGameCount() const;
+	FolderData* getParent() const; //NULL for a root folder (or one that wasn't pushed anywhere yet)
+	FolderData* getSubfolder(const std::string& path) const; //the direct subfolder with this path, or NULL
+
 	void removeFileRecursive(FileData* file);
 
+	//the system game, one of the files of this folder, belongs to - collections of several systems look it up
+	virtual SystemData* getSystem(GameData* game) const;
+
 	void pushFileData(FileData* file);
 
-	void sort(ComparisonFunction & comparisonFunction = compareFileName, bool ascending = true);
+	//Sorts this folder (not its subfolders - they're sorted when they are shown). Does nothing if the folder is already
+	//sorted that way. The sort keys and the resulting order of every sort state are cached, so switching back and forth
+	//is only a copy - until the files of the folder or the metadata of one of its games change.
+	virtual void sort(ComparisonFunction & comparisonFunction = compareFileName, bool ascending = true);
         void reselect();
 	static bool compareFileName(const FileData* file1, const FileData* file2);
 	static bool compareRating(const FileData* file1, const FileData* file2);
@@ -53,12 +72,63 @@ public:
 	static bool compareLastPlayed(const FileData* file1, const FileData* file2);
 	static std::string getSortStateName(ComparisonFunction & comparisonFunction = compareFileName, bool ascending = true);
 
+protected:
+	//everything a sort looks at, extracted from the files once
+	struct SortKey
+	{
+		FileData* file;
+		std::string name; //upper case
+		float rating;
+		int timesPlayed;
+		int64_t lastPlayed; //seconds since the epoch, never played sorts first
+		unsigned int generation; //of the game's metadata when the key was made (see MetaDataList::getGeneration())
+		const std::string* directory; //the path, in the two parts a game keeps it in - a folder's is all directory
+		const std::string* fileName;
+	};
+
+	static SortKey makeSortKey(FileData* file);
+	static bool isCurrent(const SortKey& key); //false if the metadata of the key's game changed since
+
+	typedef bool SortKeyComparison(const SortKey& a, const SortKey& b);
+	static SortKeyComparison* getSortKeyComparison(ComparisonFunction & comparisonFunction); //NULL if it isn't one of ours
+	static bool compareKeyNames(const SortKey& a, const SortKey& b);
+	static bool compareKeyRatings(const SortKey& a, const SortKey& b);
+	static bool compareKeyTimesPlayed(const SortKey& a, const SortKey& b);
+	static bool compareKeyLastPlayed(const SortKey& a, const SortKey& b);
+
+	//for folders that build their contents themselves, instead of having them pushed
+	void setFiles(const std::vector<FileData*>& files);
+
 private:
+	void invalidateSortCache();
+	void appendFilesRecursive(std::vector<FileData*>& files, bool onlyFiles) const;
+	void addGameCount(int difference); //to this folder and all of its parents
+
+	std::vector<SortKey> mSortKeys;
+	std::map<std::pair<ComparisonFunction*, bool>, std::vector<FileData*> > mSortCache; //sort state -> sorted files
+	bool mSortKeysValid;
+	std::pair<ComparisonFunction*, bool> mSortedState; //the sort state mFileVector is in, if the keys are valid
+
 	SystemData* mSystem;
+	FolderData* mParent;
+	unsigned int mGameCount;
 	std::string mPath;
 	std::string mName;
 	std::vector<FileData*> mFileVector;
+	std::unordered_map<std::string, FolderData*> mSubfolders; //path -> direct subfolder
         boost::posix_time::ptime mSelected;
 };
 
+template<typename Visitor>
+void FolderData::visitGames(const Visitor& visitor) const
+{
+	for(auto it = mFileVector.begin(); it != mFileVector.end(); it++)
+	{
+		if((*it)->isFolder())
+			static_cast<const FolderData*>(*it)->visitGames(visitor);
+		else
+			visitor(static_cast<GameData*>(*it));
+	}
+}
+
 #endif
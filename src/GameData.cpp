@@ -1,15 +1,19 @@
 #include "GameData.h"
 #include <boost/filesystem.hpp>
-#include <boost/regex/v4/regex.hpp>
 #include <iostream>
 #include <ctime>
 #include <sstream>
 
-GameData::GameData(const std::string& path, const MetaDataList& metadata)
-	: mPath(path), mBaseName(boost::filesystem::path(path).stem().string()), mMetaData(metadata)
+GameData::GameData(const std::string* directory, const std::string& fileName, const MetaDataList& metadata)
+	: mDirectory(directory), mFileName(fileName), mCleanNameValid(false), mMetaData(metadata)
 {
-	if(mMetaData.get("name").empty())
-		mMetaData.set("name", mBaseName);
+	//the default name is never written to the gamelist, so setting it doesn't make the game dirty
+	if(mMetaData.get(MDF_NAME).empty())
+	{
+		bool dirty = mMetaData.isDirty();
+		mMetaData.set(MDF_NAME, getBaseName());
+		mMetaData.setDirty(dirty);
+	}
 }
 
 bool GameData::isFolder() const
@@ -19,29 +23,39 @@ bool GameData::isFolder() const
 
 boost::posix_time::ptime GameData::isSelected() const
 {
-    return const_cast<GameData*>(this)->metadata()->getTime("selected");
+    return const_cast<GameData*>(this)->metadata()->getTime(MDF_SELECTED);
 }
 
 void GameData::setSelected(bool isSelected)
 {
     if (isSelected)
     {
-        metadata()->setTime("selected", boost::posix_time::second_clock::universal_time());
+        metadata()->setTime(MDF_SELECTED, boost::posix_time::second_clock::universal_time());
     }
     else
     {
-        metadata()->set("selected", "");
+        metadata()->set(MDF_SELECTED, "");
     }
 }
 
 const std::string& GameData::getName() const
 {
-	return mMetaData.get("name");
+	return mMetaData.getString(MDF_NAME);
+}
+
+std::string GameData::getPath() const
+{
+	return *mDirectory + mFileName;
 }
 
-const std::string& GameData::getPath() const
+const std::string& GameData::getDirectory() const
 {
-	return mPath;
+	return *mDirectory;
+}
+
+const std::string& GameData::getFileName() const
+{
+	return mFileName;
 }
 
 std::string GameData::getBashPath() const
@@ -72,27 +86,61 @@ std::string GameData::getBashPath() const
 //returns the boost::filesystem stem of our path - e.g. for "/foo/bar.rom" returns "bar"
 std::string GameData::getBaseName() const
 {
-	return mBaseName;
+	return boost::filesystem::path(mFileName).stem().string();
+}
+
+//the same as the old regex "\((.*)\)|\[(.*)\]" did, but fast enough to run over a whole library (the search index
+//does): everything from an opening bracket to the last matching closing bracket is dropped
+static std::string stripTags(const std::string& name)
+{
+	std::string out;
+	out.reserve(name.size());
+
+	size_t pos = 0;
+	while(pos < name.size())
+	{
+		char c = name[pos];
+		if(c == '(' || c == '[')
+		{
+			size_t end = name.rfind(c == '(' ? ')' : ']');
+			if(end != std::string::npos && end > pos)
+			{
+				pos = end + 1;
+				continue;
+			}
+		}
+
+		out += c;
+		pos++;
+	}
+
+	return out;
 }
 
-std::string GameData::getCleanName() const
+const std::string& GameData::getCleanName() const
 {
-	return regex_replace(mBaseName, boost::regex("\\((.*)\\)|\\[(.*)\\]"), "");
+	//the file name never changes, neither does this
+	if(!mCleanNameValid)
+	{
+		mCleanName = stripTags(getBaseName());
+		mCleanNameValid = true;
+	}
+	return mCleanName;
 }
 
 void GameData::incTimesPlayed()
 {
-	int timesPlayed = metadata()->getInt("playcount");
+	int timesPlayed = metadata()->getInt(MDF_PLAYCOUNT);
 	timesPlayed++;
 
 	std::stringstream ss;
-	metadata()->set("playcount", std::to_string(static_cast<long long>(timesPlayed)));
+	metadata()->set(MDF_PLAYCOUNT, std::to_string(static_cast<long long>(timesPlayed)));
 }
 
 void GameData::lastPlayedNow()
 {
 	boost::posix_time::ptime time = boost::posix_time::second_clock::universal_time();
-	metadata()->setTime("lastplayed", time);
+	metadata()->setTime(MDF_LASTPLAYED, time);
 }
 
 MetaDataList* GameData::metadata()
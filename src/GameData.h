@@ -10,17 +10,20 @@
 class GameData : public FileData
 {
 public:
-	GameData(const std::string& path, const MetaDataList& metadata);
+	//directory is the path up to and including the last '/', shared by all games in it (see SystemData::createGame)
+	GameData(const std::string* directory, const std::string& fileName, const MetaDataList& metadata);
 
 	const std::string& getName() const override;
-	const std::string& getPath() const override;
+	std::string getPath() const override; //builds the path, for display and I/O - compare getDirectory() and getFileName() instead
+	const std::string& getDirectory() const; //the same object for every game in a directory of a system, compare by address
+	const std::string& getFileName() const;
 	
 	void incTimesPlayed();
 	void lastPlayedNow();
 
 	std::string getBashPath() const;
 	std::string getBaseName() const;
-	std::string getCleanName() const;
+	const std::string& getCleanName() const; //the base name without any (tags) or [tags], kept once it was asked for
 
 	bool isFolder() const override;
         boost::posix_time::ptime isSelected() const override;
@@ -29,8 +32,10 @@ public:
 	MetaDataList* metadata();
 
 private:
-	const std::string mPath;
-	const std::string mBaseName;
+	const std::string* mDirectory;
+	const std::string mFileName;
+	mutable std::string mCleanName;
+	mutable bool mCleanNameValid;
 
 	MetaDataList mMetaData;
 };
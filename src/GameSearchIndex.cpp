@@ -0,0 +1,374 @@
+#include "GameSearchIndex.h"
+#include "GameData.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+	//an index with this many holes is compacted once half of it is holes
+	const size_t COMPACT_MIN_REMOVED = 1024;
+
+	bool isSeparator(char c)
+	{
+		return c == ' ' || c == '\n';
+	}
+
+	//finds word in text; with atWordStart only where a word of text starts with it
+	bool containsWord(const std::string& text, const std::string& word, bool atWordStart)
+	{
+		size_t pos = text.find(word);
+		while(pos != std::string::npos)
+		{
+			if(!atWordStart || pos == 0 || isSeparator(text[pos - 1]))
+				return true;
+			pos = text.find(word, pos + 1);
+		}
+		return false;
+	}
+
+	void addPosting(std::vector<uint32_t>& list, uint32_t id)
+	{
+		//ids only ever grow, a word or trigram that appears twice in one entry is listed once
+		if(list.empty() || list.back() != id)
+			list.push_back(id);
+	}
+
+	void intersect(std::vector<uint32_t>& into, const std::vector<uint32_t>& other)
+	{
+		std::vector<uint32_t> result;
+		std::set_intersection(into.begin(), into.end(), other.begin(), other.end(), std::back_inserter(result));
+		into.swap(result);
+	}
+
+	bool isSmaller(const std::vector<uint32_t>* a, const std::vector<uint32_t>* b)
+	{
+		return a->size() < b->size();
+	}
+}
+
+GameSearchIndex::GameSearchIndex() : mRemoved(0), mOrderValid(false)
+{
+}
+
+std::string GameSearchIndex::normalize(const std::string& text)
+{
+	std::string out;
+	out.reserve(text.size());
+
+	bool separate = false;
+	for(unsigned int i = 0; i < text.size(); i++)
+	{
+		unsigned char c = (unsigned char)text[i];
+		if(c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+
+		//anything outside of ASCII is part of a UTF-8 sequence and kept as it is
+		if((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80)
+		{
+			if(separate && !out.empty())
+				out += ' ';
+			separate = false;
+			out += (char)c;
+		}else{
+			separate = true;
+		}
+	}
+
+	return out;
+}
+
+uint32_t GameSearchIndex::getTrigram(const char* str)
+{
+	return ((uint32_t)(unsigned char)str[0] << 16) | ((uint32_t)(unsigned char)str[1] << 8) | (uint32_t)(unsigned char)str[2];
+}
+
+uint32_t GameSearchIndex::getPrefix(const char* str, size_t length)
+{
+	//the length is part of the key, so one and two character prefixes never collide
+	uint32_t prefix = (uint32_t)length << 16;
+	for(size_t i = 0; i < length; i++)
+		prefix |= (uint32_t)(unsigned char)str[i] << (8 * (1 - i));
+	return prefix;
+}
+
+size_t GameSearchIndex::size() const
+{
+	return mIds.size();
+}
+
+void GameSearchIndex::add(GameData* game)
+{
+	if(mIds.find(game) != mIds.end())
+		return;
+
+	addEntry(game);
+}
+
+void GameSearchIndex::addEntry(GameData* game)
+{
+	uint32_t id = (uint32_t)mEntries.size();
+	mIds[game] = id;
+
+	Entry entry;
+	entry.game = game;
+	entry.text = normalize(game->getName());
+
+	std::string clean = normalize(game->getCleanName());
+	if(!clean.empty() && clean != entry.text)
+	{
+		if(!entry.text.empty())
+			entry.text += '\n';
+		entry.text += clean;
+	}
+
+	const std::string& text = entry.text;
+	size_t wordStart = 0;
+	for(size_t i = 0; i <= text.size(); i++)
+	{
+		if(i < text.size() && !isSeparator(text[i]))
+		{
+			size_t length = i - wordStart + 1;
+			if(length <= 2)
+				addPosting(mPrefixes[getPrefix(text.c_str() + wordStart, length)], id);
+			else
+				addPosting(mTrigrams[getTrigram(text.c_str() + i - 2)], id);
+			continue;
+		}
+
+		wordStart = i + 1;
+	}
+
+	mEntries.push_back(entry);
+	if(mOrderValid)
+		insertOrder(id);
+}
+
+void GameSearchIndex::remove(GameData* game)
+{
+	auto it = mIds.find(game);
+	if(it == mIds.end())
+		return;
+
+	if(mOrderValid)
+		eraseOrder(it->second);
+
+	Entry& entry = mEntries.at(it->second);
+	entry.game = NULL;
+	entry.text.clear();
+	mIds.erase(it);
+	mRemoved++;
+
+	if(mRemoved >= COMPACT_MIN_REMOVED && mRemoved * 2 >= mEntries.size())
+		compact();
+}
+
+void GameSearchIndex::update(GameData* game)
+{
+	if(mIds.find(game) == mIds.end())
+		return;
+
+	remove(game);
+	addEntry(game);
+}
+
+void GameSearchIndex::clear()
+{
+	mEntries.clear();
+	mIds.clear();
+	mRemoved = 0;
+	mTrigrams.clear();
+	mPrefixes.clear();
+	mOrder.clear();
+	mSorted.clear();
+
+	//whatever is added next (usually everything) is sorted at once
+	mOrderValid = false;
+}
+
+void GameSearchIndex::compact()
+{
+	//if the order is known, the games are added again in it - so it stays known without sorting anything
+	bool ordered = mOrderValid;
+
+	std::vector<GameData*> games;
+	games.reserve(mIds.size());
+	if(ordered)
+	{
+		for(auto it = mSorted.begin(); it != mSorted.end(); it++)
+			games.push_back(mEntries[*it].game);
+	}else{
+		for(auto it = mEntries.begin(); it != mEntries.end(); it++)
+		{
+			if(it->game)
+				games.push_back(it->game);
+		}
+	}
+
+	clear();
+	for(auto it = games.begin(); it != games.end(); it++)
+		addEntry(*it);
+
+	if(ordered)
+	{
+		mSorted.resize(mEntries.size());
+		mOrder.resize(mEntries.size());
+		for(uint32_t id = 0; id < mEntries.size(); id++)
+			mSorted[id] = mOrder[id] = id;
+		mOrderValid = true;
+	}
+}
+
+const GameSearchIndex::PostingList* GameSearchIndex::findCandidates(const std::string& word, PostingList& scratch) const
+{
+	if(word.size() < 3)
+	{
+		auto it = mPrefixes.find(getPrefix(word.c_str(), word.size()));
+		return it == mPrefixes.end() ? NULL : &it->second;
+	}
+
+	//every entry that has all trigrams of word, smallest list first
+	std::vector<const PostingList*> lists;
+	for(size_t i = 0; i + 3 <= word.size(); i++)
+	{
+		auto it = mTrigrams.find(getTrigram(word.c_str() + i));
+		if(it == mTrigrams.end())
+			return NULL;
+		lists.push_back(&it->second);
+	}
+
+	if(lists.size() == 1)
+		return lists.front();
+
+	std::sort(lists.begin(), lists.end(), isSmaller);
+	scratch = *lists.front();
+	for(unsigned int i = 1; i < lists.size() && !scratch.empty(); i++)
+		intersect(scratch, *lists.at(i));
+	return &scratch;
+}
+
+void GameSearchIndex::updateOrder() const
+{
+	if(mOrderValid)
+		return;
+
+	mSorted.clear();
+	mSorted.reserve(mIds.size());
+	for(uint32_t id = 0; id < mEntries.size(); id++)
+	{
+		if(mEntries[id].game)
+			mSorted.push_back(id);
+	}
+
+	std::sort(mSorted.begin(), mSorted.end(), [this](uint32_t a, uint32_t b) { return mEntries[a].text < mEntries[b].text; });
+
+	mOrder.resize(mEntries.size());
+	for(uint32_t pos = 0; pos < mSorted.size(); pos++)
+		mOrder[mSorted[pos]] = pos;
+
+	mOrderValid = true;
+}
+
+void GameSearchIndex::insertOrder(uint32_t id)
+{
+	//only the entries after it move, and just by one - no string is compared but on the way to its position
+	const std::string& text = mEntries[id].text;
+	auto it = std::upper_bound(mSorted.begin(), mSorted.end(), id, [this, &text](uint32_t, uint32_t other) { return text < mEntries[other].text; });
+	uint32_t pos = (uint32_t)(it - mSorted.begin());
+	mSorted.insert(it, id);
+
+	mOrder.resize(mEntries.size());
+	for(uint32_t i = pos; i < mSorted.size(); i++)
+		mOrder[mSorted[i]] = i;
+}
+
+void GameSearchIndex::eraseOrder(uint32_t id)
+{
+	uint32_t pos = mOrder.at(id);
+	mSorted.erase(mSorted.begin() + pos);
+
+	for(uint32_t i = pos; i < mSorted.size(); i++)
+		mOrder[mSorted[i]] = i;
+}
+
+void GameSearchIndex::find(const std::string& query, std::vector<GameData*>& results, size_t maxResults) const
+{
+	std::string normalized = normalize(query);
+	if(normalized.empty() || maxResults == 0)
+		return;
+
+	std::vector<std::string> words;
+	size_t start = 0;
+	while(start < normalized.size())
+	{
+		size_t end = normalized.find(' ', start);
+		if(end == std::string::npos)
+			end = normalized.size();
+
+		std::string word = normalized.substr(start, end - start);
+		if(std::find(words.begin(), words.end(), word) == words.end())
+			words.push_back(word);
+		start = end + 1;
+	}
+
+	//the candidates have every word, the smallest candidate list is intersected first
+	std::vector<PostingList> scratch(words.size());
+	std::vector<const PostingList*> lists;
+	for(unsigned int i = 0; i < words.size(); i++)
+	{
+		const PostingList* list = findCandidates(words.at(i), scratch.at(i));
+		if(list == NULL || list->empty())
+			return;
+		lists.push_back(list);
+	}
+
+	std::sort(lists.begin(), lists.end(), isSmaller);
+
+	PostingList intersection;
+	const PostingList* candidates = lists.front();
+	if(lists.size() > 1)
+	{
+		intersection = *candidates;
+		for(unsigned int i = 1; i < lists.size() && !intersection.empty(); i++)
+			intersect(intersection, *lists.at(i));
+		candidates = &intersection;
+	}
+
+	updateOrder();
+
+	//a single short word was found at the start of a word, everything else still has to be checked for that
+	bool startsWord = (words.size() == 1 && words.front().size() < 3);
+
+	//trigrams only say a long word might be there, check it really is - words of up to three characters were exact already
+	std::vector<uint64_t> matches; //rank, alphabetical position
+	matches.reserve(candidates->size());
+	for(auto it = candidates->begin(); it != candidates->end(); it++)
+	{
+		const Entry& entry = mEntries.at(*it);
+		if(entry.game == NULL)
+			continue;
+
+		bool found = true;
+		for(auto word = words.begin(); word != words.end() && found; word++)
+		{
+			if(word->size() > 3)
+				found = containsWord(entry.text, *word, false);
+		}
+
+		if(!found)
+			continue;
+
+		uint64_t rank = 2;
+		if(entry.text.compare(0, normalized.size(), normalized) == 0)
+			rank = 0;
+		else if(startsWord || containsWord(entry.text, normalized, true))
+			rank = 1;
+
+		matches.push_back((rank << 32) | mOrder[*it]);
+	}
+
+	size_t count = std::min(matches.size(), maxResults);
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end());
+
+	for(size_t i = 0; i < count; i++)
+		results.push_back(mEntries.at(mSorted.at((uint32_t)matches.at(i))).game);
+}
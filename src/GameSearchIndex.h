@@ -0,0 +1,71 @@
+#ifndef _GAMESEARCHINDEX_H_
+#define _GAMESEARCHINDEX_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class GameData;
+
+//A search index over the names of a set of games, for type-to-search.
+//Names and clean names are reduced to lower case words; every word of a query has to be found in a game's text.
+//Words of three or more characters may appear anywhere (found through a trigram index), shorter words have to start
+//a word (found through an index of word prefixes) - "zel" finds "The Legend of Zelda", "ze" does too, "lda" is found, "da" isn't.
+//Removed games leave a hole that is skipped; the index is compacted once half of it is holes.
+//Not thread safe.
+class GameSearchIndex
+{
+public:
+	GameSearchIndex();
+
+	void add(GameData* game);
+	void remove(GameData* game);
+	//call this when the name of a game changed
+	void update(GameData* game);
+	void clear();
+
+	size_t size() const;
+
+	//Appends the games matching query to results, best matches first (names starting with the query, then names
+	//with a word starting with it, then the rest, each alphabetically). At most maxResults are added.
+	//An empty query matches nothing.
+	void find(const std::string& query, std::vector<GameData*>& results, size_t maxResults) const;
+
+	//Reduces text to lower case words separated by single spaces, the form everything in the index is stored in.
+	static std::string normalize(const std::string& text);
+
+private:
+	struct Entry
+	{
+		GameData* game; //NULL once removed
+		std::string text; //normalized name, and the normalized clean name if it differs, separated by '\n'
+	};
+
+	typedef std::vector<uint32_t> PostingList; //entry ids, ascending
+
+	void addEntry(GameData* game);
+	void compact();
+	const PostingList* findCandidates(const std::string& word, PostingList& scratch) const;
+	void updateOrder() const;
+	void insertOrder(uint32_t id);
+	void eraseOrder(uint32_t id);
+
+	static uint32_t getTrigram(const char* str);
+	static uint32_t getPrefix(const char* str, size_t length);
+
+	std::vector<Entry> mEntries;
+	std::unordered_map<GameData*, uint32_t> mIds;
+	size_t mRemoved;
+
+	std::unordered_map<uint32_t, PostingList> mTrigrams; //trigram inside a word -> entries
+	std::unordered_map<uint32_t, PostingList> mPrefixes; //first one or two characters of a word -> entries
+
+	//The alphabetical order of the entries, results are sorted by it. Sorted by the first find() after the index was
+	//(re)built, from then on every added or removed entry is just moved in or out of it.
+	mutable std::vector<uint32_t> mOrder; //entry id -> position
+	mutable std::vector<uint32_t> mSorted; //position -> entry id, without removed entries
+	mutable bool mOrderValid;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "GamelistCache.h"
+#include "BinaryIO.h"
+#include "XMLReader.h"
+#include "SystemData.h"
+#include "GameData.h"
+#include "Log.h"
+#include "platform.h"
+#include <boost/filesystem.hpp>
+#include <sys/stat.h>
+
+namespace
+{
+	const char CACHE_MAGIC[4] = { 'E', 'S', 'G', 'C' };
+	const uint32_t CACHE_VERSION = 3;
+
+	struct XMLStamp
+	{
+		uint64_t size;
+		int64_t mtimeSec;
+		int64_t mtimeNsec;
+	};
+
+	bool getXMLStamp(const std::string& xmlpath, XMLStamp& stamp)
+	{
+		struct stat st;
+		if(stat(xmlpath.c_str(), &st) != 0)
+			return false;
+
+		stamp.size = (uint64_t)st.st_size;
+		stamp.mtimeSec = (int64_t)st.st_mtime;
+#if defined(__linux__)
+		stamp.mtimeNsec = (int64_t)st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+		stamp.mtimeNsec = (int64_t)st.st_mtimespec.tv_nsec;
+#else
+		stamp.mtimeNsec = 0;
+#endif
+		return true;
+	}
+
+	//not next to the XML - that is often in the ROM directory, where the cache could be mistaken for a game and
+	//writing it would change the directory (and invalidate its scan cache)
+	std::string getCachePath(const std::string& systemName)
+	{
+		return getHomePath() + "/.emulationstation/gamelists/" + systemName + ".cache";
+	}
+}
+
+bool loadGamelistCache(SystemData* system)
+{
+	std::string xmlpath = system->getGamelistPath();
+
+	XMLStamp stamp;
+	if(!getXMLStamp(xmlpath, stamp))
+		return false;
+
+	std::string cachePath = getCachePath(system->getName());
+	MappedFile file;
+	if(!file.open(cachePath))
+		return false;
+
+	BinaryReader reader(file.data(), file.size());
+	if(!reader.readMagic(CACHE_MAGIC, sizeof(CACHE_MAGIC)) || reader.read<uint32_t>() != CACHE_VERSION)
+	{
+		LOG(LogInfo) << "Gamelist cache \"" << cachePath << "\" is from a different version, ignoring it";
+		return false;
+	}
+
+	//the system's gamelist may have moved (see SystemData::getGamelistPath())
+	if(reader.readString() != xmlpath || reader.read<uint64_t>() != stamp.size || reader.read<int64_t>() != stamp.mtimeSec || reader.read<int64_t>() != stamp.mtimeNsec)
+		return false; //the XML changed since, it has to be parsed again
+
+	//Read straight into the games. If the cache turns out to be broken halfway, parsing the XML sets every one of them
+	//again - and any game created on the way has an entry in there too, the XML didn't change since.
+	uint32_t gameCount = reader.read<uint32_t>();
+	LOG(LogInfo) << "Loading " << gameCount << " game(s) from gamelist cache \"" << cachePath << "\"";
+
+	MetaDataList skipped(system->getGameMDD()); //for entries of games that don't exist anymore
+	bool intact = true;
+	for(uint32_t i = 0; i < gameCount; i++)
+	{
+		GameData* game = getGamelistGame(system, reader.readString());
+		MetaDataList* metadata = game ? game->metadata() : &skipped;
+		intact = metadata->readBinary(reader);
+		if(!intact)
+			break;
+
+		metadata->setDirty(false);
+		if(game)
+			gamelistEntryLoaded(system, game);
+	}
+
+	if(!intact || !reader.ok() || !reader.atEnd())
+	{
+		LOG(LogWarning) << "Gamelist cache \"" << cachePath << "\" is corrupt, ignoring it";
+		return false;
+	}
+
+	return true;
+}
+
+GamelistCacheWriter::GamelistCacheWriter() : mGameCount(0)
+{
+}
+
+void GamelistCacheWriter::add(const std::string& path, const MetaDataList& metadata)
+{
+	writeBinaryString(mGames, path);
+	metadata.writeBinary(mGames);
+	mGameCount++;
+}
+
+void GamelistCacheWriter::write(const std::string& systemName, const std::string& xmlpath) const
+{
+	XMLStamp stamp;
+	if(!getXMLStamp(xmlpath, stamp))
+		return;
+
+	std::string data;
+	data.reserve(64 + xmlpath.size() + mGames.size());
+	data.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeBinaryValue<uint32_t>(data, CACHE_VERSION);
+	writeBinaryString(data, xmlpath);
+	writeBinaryValue<uint64_t>(data, stamp.size);
+	writeBinaryValue<int64_t>(data, stamp.mtimeSec);
+	writeBinaryValue<int64_t>(data, stamp.mtimeNsec);
+	writeBinaryValue<uint32_t>(data, mGameCount);
+	data.append(mGames);
+
+	writeFileAtomically(getCachePath(systemName), data);
+}
+
+void writeGamelistCache(const std::string& systemName, const std::string& xmlpath, const pugi::xml_node& root, const std::vector<MetaDataDecl>& mdd)
+{
+	GamelistCacheWriter writer;
+	for(pugi::xml_node gameNode = root.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
+	{
+		pugi::xml_node pathNode = gameNode.child("path");
+		if(pathNode)
+			writer.add(resolveGamePath(pathNode.text().get(), xmlpath), MetaDataList::createFromXML(mdd, gameNode));
+	}
+
+	writer.write(systemName, xmlpath);
+}
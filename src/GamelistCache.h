@@ -0,0 +1,40 @@
+#ifndef _GAMELISTCACHE_H_
+#define _GAMELISTCACHE_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "pugiXML/pugixml.hpp"
+#include "MetaData.h"
+
+class SystemData;
+
+//A binary copy of a parsed gamelist.xml, kept in ~/.emulationstation/gamelists/<system name>.cache.
+//It's only used while the XML has the size and modification time it had when the copy was made, so the XML stays the
+//file that counts - edit it by hand and the next start parses it again.
+//Metadata is stored the way MetaDataList keeps it (see MetaDataList::writeBinary()), so loading it parses nothing.
+
+//Loads the games of system from the cache of its gamelist. Returns false (and changes nothing) if there's no fresh cache.
+bool loadGamelistCache(SystemData* system);
+
+//Collects the entries of a gamelist, to write them as its cache.
+class GamelistCacheWriter
+{
+public:
+	GamelistCacheWriter();
+
+	//path as resolved by resolveGamePath()
+	void add(const std::string& path, const MetaDataList& metadata);
+
+	//Writes the cache for the (already saved) gamelist xmlpath of system systemName.
+	void write(const std::string& systemName, const std::string& xmlpath) const;
+
+private:
+	std::string mGames;
+	uint32_t mGameCount;
+};
+
+//Same as above, for the <gameList> node root of xmlpath - every entry in it is parsed with mdd.
+void writeGamelistCache(const std::string& systemName, const std::string& xmlpath, const pugi::xml_node& root, const std::vector<MetaDataDecl>& mdd);
+
+#endif
@@ -0,0 +1,134 @@
+#include "GamelistWriter.h"
+#include "SystemData.h"
+#include "Log.h"
+
+namespace
+{
+	//how long changes are collected before they're written
+	const std::chrono::milliseconds WRITE_DELAY(3000);
+
+	//adds the games of from to into, games in from are newer
+	void mergeSnapshot(GamelistSnapshot& into, const GamelistSnapshot& from)
+	{
+		for(auto it = from.games.begin(); it != from.games.end(); it++)
+		{
+			into.games.erase(it->first);
+			into.games.insert(*it);
+		}
+	}
+}
+
+GamelistWriter* GamelistWriter::sInstance = NULL;
+
+GamelistWriter* GamelistWriter::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new GamelistWriter();
+
+	return sInstance;
+}
+
+GamelistWriter::GamelistWriter() : mRunning(false)
+{
+}
+
+void GamelistWriter::queue(SystemData* system)
+{
+	GamelistSnapshot snapshot;
+	if(!takeGamelistChanges(system, snapshot))
+		return;
+
+	std::lock_guard<std::mutex> lock(mPendingMutex);
+
+	if(mPending.empty())
+		mFirstPending = Clock::now();
+
+	auto it = mPending.find(snapshot.xmlPath);
+	if(it == mPending.end())
+		mPending.insert(std::make_pair(snapshot.xmlPath, snapshot));
+	else
+		mergeSnapshot(it->second, snapshot);
+
+	if(!mRunning)
+	{
+		mRunning = true;
+		mThread = std::thread(&GamelistWriter::run, this);
+	}
+
+	mPendingCondition.notify_one();
+}
+
+void GamelistWriter::flush()
+{
+	writePending();
+}
+
+void GamelistWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mPendingMutex);
+		mRunning = false;
+		mPendingCondition.notify_one();
+	}
+
+	if(mThread.joinable())
+		mThread.join();
+
+	flush();
+}
+
+void GamelistWriter::run()
+{
+	std::unique_lock<std::mutex> lock(mPendingMutex);
+	while(mRunning)
+	{
+		if(mPending.empty())
+		{
+			mPendingCondition.wait(lock);
+			continue;
+		}
+
+		Clock::time_point due = mFirstPending + WRITE_DELAY;
+		if(Clock::now() < due)
+		{
+			mPendingCondition.wait_until(lock, due);
+			continue;
+		}
+
+		lock.unlock();
+		writePending();
+		lock.lock();
+	}
+}
+
+void GamelistWriter::writePending()
+{
+	std::lock_guard<std::mutex> writeLock(mWriteMutex);
+
+	std::map<std::string, GamelistSnapshot> pending;
+	{
+		std::lock_guard<std::mutex> lock(mPendingMutex);
+		pending.swap(mPending);
+	}
+
+	for(auto it = pending.begin(); it != pending.end(); it++)
+	{
+		LOG(LogInfo) << "Writing " << it->second.games.size() << " changed game(s) of " << it->second.systemName << " to \"" << it->first << "\"";
+		if(writeGamelist(it->second))
+			continue;
+
+		//keep the changes around and try again with the next write, anything queued since then is newer
+		std::lock_guard<std::mutex> lock(mPendingMutex);
+		if(mPending.empty())
+			mFirstPending = Clock::now();
+
+		auto newer = mPending.find(it->first);
+		if(newer != mPending.end())
+		{
+			mergeSnapshot(it->second, newer->second);
+			newer->second = it->second;
+		}else{
+			mPending.insert(*it);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef _GAMELISTWRITER_H_
+#define _GAMELISTWRITER_H_
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include "XMLReader.h"
+
+class SystemData;
+
+//Writes gamelist.xml files on a background thread.
+//queue() copies a system's changed games right away; the write happens a few seconds later, so a scraping session
+//that changes a game every second rewrites each gamelist once per delay instead of once per game.
+class GamelistWriter
+{
+public:
+	static GamelistWriter* getInstance();
+
+	//Takes the changes of system and schedules a write. Main thread only.
+	void queue(SystemData* system);
+
+	//Writes everything that is queued on the calling thread and returns when it's on disk.
+	void flush();
+
+	//Flushes and stops the background thread (it is started again by the next queue()).
+	void stop();
+
+private:
+	GamelistWriter();
+
+	typedef std::chrono::steady_clock Clock;
+
+	void run();
+	void writePending();
+
+	static GamelistWriter* sInstance;
+
+	std::thread mThread;
+	bool mRunning;
+
+	//held while writing, keeps writes in the order their changes were queued
+	std::mutex mWriteMutex;
+
+	std::mutex mPendingMutex;
+	std::condition_variable mPendingCondition;
+	std::map<std::string, GamelistSnapshot> mPending; //gamelist path -> changes
+	Clock::time_point mFirstPending;
+};
+
+#endif
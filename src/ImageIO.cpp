@@ -1,27 +1,302 @@
 #include "ImageIO.h"
 
 #include <memory.h>
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
 
 #include "Log.h"
 
+//the vector code only handles FreeImage's little endian layout, BGRA
+#if FI_RGBA_RED == 2 && FI_RGBA_GREEN == 1 && FI_RGBA_BLUE == 0 && FI_RGBA_ALPHA == 3
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGEIO_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGEIO_USE_NEON
+#endif
+#endif
+
+namespace
+{
+	//the factor an image of sourceWidth x sourceHeight is scaled by so it still covers targetWidth x targetHeight
+	//(0 = any size), never more than 1
+	double getCoverScale(size_t sourceWidth, size_t sourceHeight, size_t targetWidth, size_t targetHeight)
+	{
+		if((targetWidth == 0 && targetHeight == 0) || sourceWidth == 0 || sourceHeight == 0)
+			return 1.0;
+
+		double scale = 0.0;
+		if(targetWidth != 0)
+			scale = std::max(scale, (double)targetWidth / sourceWidth);
+		if(targetHeight != 0)
+			scale = std::max(scale, (double)targetHeight / sourceHeight);
+
+		return std::min(scale, 1.0);
+	}
+
+	//one pixel at a time, for what's left over after the vector code (and machines without any)
+	void convertToRGBA32Scalar(const unsigned char * src, unsigned char * dest, size_t pixels)
+	{
+		for(size_t i = 0; i < pixels; i++)
+		{
+			const unsigned char red = src[FI_RGBA_RED];
+			const unsigned char green = src[FI_RGBA_GREEN];
+			const unsigned char blue = src[FI_RGBA_BLUE];
+			const unsigned char alpha = src[FI_RGBA_ALPHA];
+			dest[0] = red;
+			dest[1] = green;
+			dest[2] = blue;
+			dest[3] = alpha;
+			src += 4;
+			dest += 4;
+		}
+	}
+
+	//every destination pixel is the average of the box of source pixels it covers
+	//bitmap is 32 bit, dest is width x height (neither bigger than the bitmap) with no padding between lines, in RGBA
+	void downscaleBox(FIBITMAP* bitmap, unsigned char* dest, size_t width, size_t height)
+	{
+		const size_t sourceWidth = FreeImage_GetWidth(bitmap);
+		const size_t sourceHeight = FreeImage_GetHeight(bitmap);
+
+		//first source column of every destination column, plus the end
+		std::vector<size_t> columns(width + 1);
+		for(size_t x = 0; x <= width; x++)
+			columns[x] = x * sourceWidth / width;
+
+		std::vector<uint32_t> sums(width * 4);
+		for(size_t y = 0; y < height; y++)
+		{
+			const size_t firstLine = y * sourceHeight / height;
+			const size_t endLine = (y + 1) * sourceHeight / height;
+
+			std::fill(sums.begin(), sums.end(), 0);
+			for(size_t line = firstLine; line < endLine; line++)
+			{
+				const BYTE * scanLine = FreeImage_GetScanLine(bitmap, line);
+				for(size_t x = 0; x < width; x++)
+				{
+					uint32_t* sum = &sums[x * 4];
+					for(const BYTE * pixel = scanLine + columns[x] * 4; pixel < scanLine + columns[x + 1] * 4; pixel += 4)
+					{
+						sum[0] += pixel[0];
+						sum[1] += pixel[1];
+						sum[2] += pixel[2];
+						sum[3] += pixel[3];
+					}
+				}
+			}
+
+			unsigned char* out = dest + y * width * 4;
+			for(size_t x = 0; x < width; x++)
+			{
+				const uint32_t count = (uint32_t)((columns[x + 1] - columns[x]) * (endLine - firstLine));
+				for(size_t c = 0; c < 4; c++)
+					out[x * 4 + c] = (unsigned char)((sums[x * 4 + c] + count / 2) / count);
+			}
+
+			//while the line is still in the cache
+			ImageIO::convertToRGBA32(out, out, width);
+		}
+	}
+}
+
+size_t ImageIO::getBytesPerPixel(PixelFormat format)
+{
+	return format == PIXEL_RGBA8888 ? 4 : 2;
+}
+
+bool ImageIO::isOpaque(const unsigned char * imageRGBA, size_t pixels)
+{
+	size_t i = 0;
+
+#if defined(IMAGEIO_USE_SSE2)
+	//set every color byte, the result only has all bits set if every alpha byte does too
+	const __m128i color = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i all = _mm_set1_epi32(-1);
+	for(; i + 4 <= pixels; i += 4)
+	{
+		const __m128i rgba = _mm_or_si128(_mm_loadu_si128((const __m128i *)(imageRGBA + i * 4)), color);
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(rgba, all)) != 0xFFFF)
+			return false;
+	}
+#elif defined(IMAGEIO_USE_NEON)
+	for(; i + 16 <= pixels; i += 16)
+	{
+		const uint8x16x4_t rgba = vld4q_u8(imageRGBA + i * 4);
+		const uint8x8_t alpha = vand_u8(vget_low_u8(rgba.val[3]), vget_high_u8(rgba.val[3]));
+		if(vget_lane_u64(vreinterpret_u64_u8(alpha), 0) != 0xFFFFFFFFFFFFFFFFULL)
+			return false;
+	}
+#endif
+
+	for(; i < pixels; i++)
+	{
+		if(imageRGBA[i * 4 + 3] != 0xFF)
+			return false;
+	}
+
+	return true;
+}
+
+void ImageIO::packPixels(const unsigned char * src, unsigned char * dest, size_t pixels, PixelFormat format)
+{
+	if(format == PIXEL_RGBA8888)
+	{
+		if(src != dest)
+			memcpy(dest, src, pixels * 4);
+		return;
+	}
+
+	uint16_t * out = (uint16_t *)dest;
+	size_t i = 0;
+
+	//every chunk is read completely before it's written, and the output never overtakes the input - packing in place
+	//is fine
+#if defined(IMAGEIO_USE_SSE2)
+	const __m128i red565 = _mm_set1_epi32(0x000000F8);
+	const __m128i green565 = _mm_set1_epi32(0x0000FC00);
+	const __m128i blue565 = _mm_set1_epi32(0x00F80000);
+	const __m128i red4444 = _mm_set1_epi32(0x000000F0);
+	const __m128i green4444 = _mm_set1_epi32(0x0000F000);
+	const __m128i blue4444 = _mm_set1_epi32(0x00F00000);
+	for(; i + 8 <= pixels; i += 8)
+	{
+		__m128i packed[2];
+		for(int half = 0; half < 2; half++)
+		{
+			const __m128i rgba = _mm_loadu_si128((const __m128i *)(src + (i + half * 4) * 4));
+			__m128i value;
+			if(format == PIXEL_RGB565)
+			{
+				value = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(rgba, red565), 8),
+					_mm_or_si128(_mm_srli_epi32(_mm_and_si128(rgba, green565), 5), _mm_srli_epi32(_mm_and_si128(rgba, blue565), 19)));
+			}else{
+				value = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(rgba, red4444), 8), _mm_srli_epi32(_mm_and_si128(rgba, green4444), 4)),
+					_mm_or_si128(_mm_srli_epi32(_mm_and_si128(rgba, blue4444), 16), _mm_srli_epi32(rgba, 28)));
+			}
+			//sign extend, so the signed saturation of _mm_packs_epi32 leaves the 16 bit values alone
+			packed[half] = _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+		}
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(packed[0], packed[1]));
+	}
+#elif defined(IMAGEIO_USE_NEON)
+	for(; i + 8 <= pixels; i += 8)
+	{
+		const uint8x8x4_t rgba = vld4_u8(src + i * 4);
+		uint16x8_t value = vshll_n_u8(rgba.val[0], 8);
+		if(format == PIXEL_RGB565)
+		{
+			value = vsriq_n_u16(value, vshll_n_u8(rgba.val[1], 8), 5);
+			value = vsriq_n_u16(value, vshll_n_u8(rgba.val[2], 8), 11);
+		}else{
+			value = vsriq_n_u16(value, vshll_n_u8(rgba.val[1], 8), 4);
+			value = vsriq_n_u16(value, vshll_n_u8(rgba.val[2], 8), 8);
+			value = vsriq_n_u16(value, vshll_n_u8(rgba.val[3], 8), 12);
+		}
+		vst1q_u16(out + i, value);
+	}
+#endif
+
+	for(; i < pixels; i++)
+	{
+		const unsigned char * pixel = src + i * 4;
+		if(format == PIXEL_RGB565)
+			out[i] = (uint16_t)(((pixel[0] & 0xF8) << 8) | ((pixel[1] & 0xFC) << 3) | (pixel[2] >> 3));
+		else
+			out[i] = (uint16_t)(((pixel[0] & 0xF0) << 8) | ((pixel[1] & 0xF0) << 4) | (pixel[2] & 0xF0) | (pixel[3] >> 4));
+	}
+}
+
+void ImageIO::convertToRGBA32(const unsigned char * src, unsigned char * dest, size_t pixels)
+{
+	size_t i = 0;
+
+#if defined(IMAGEIO_USE_SSE2)
+	//four pixels at a time: keep green and alpha, swap the bytes of red and blue
+	const __m128i greenAlpha = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i lowByte = _mm_set1_epi32(0x000000FF);
+	for(; i + 4 <= pixels; i += 4)
+	{
+		const __m128i bgra = _mm_loadu_si128((const __m128i *)(src + i * 4));
+		const __m128i red = _mm_and_si128(_mm_srli_epi32(bgra, 16), lowByte);
+		const __m128i blue = _mm_slli_epi32(_mm_and_si128(bgra, lowByte), 16);
+		_mm_storeu_si128((__m128i *)(dest + i * 4), _mm_or_si128(_mm_and_si128(bgra, greenAlpha), _mm_or_si128(red, blue)));
+	}
+#elif defined(IMAGEIO_USE_NEON)
+	//sixteen pixels at a time, split into one register per channel
+	for(; i + 16 <= pixels; i += 16)
+	{
+		uint8x16x4_t bgra = vld4q_u8(src + i * 4);
+		const uint8x16_t blue = bgra.val[0];
+		bgra.val[0] = bgra.val[2];
+		bgra.val[2] = blue;
+		vst4q_u8(dest + i * 4, bgra);
+	}
+#endif
+
+	convertToRGBA32Scalar(src + i * 4, dest + i * 4, pixels - i);
+}
 
 std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height)
+{
+	size_t sourceWidth, sourceHeight;
+	return loadFromMemoryRGBA32(data, size, 0, 0, width, height, sourceWidth, sourceHeight);
+}
+
+std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t targetWidth, size_t targetHeight,
+	size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight)
 {
 	std::vector<unsigned char> rawData;
+	loadFromMemoryRGBA32(data, size, targetWidth, targetHeight, rawData, width, height, sourceWidth, sourceHeight);
+	return rawData;
+}
+
+bool ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t targetWidth, size_t targetHeight,
+	std::vector<unsigned char> & rawData, size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight)
+{
+	rawData.clear();
 	width = 0;
 	height = 0;
+	sourceWidth = 0;
+	sourceHeight = 0;
 	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, size);
 	if (fiMemory != nullptr) {
 		//detect the filetype from data
 		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
 		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
 		{
+			int flags = 0;
+#ifdef FIF_LOAD_NOPIXELS
+			if (format == FIF_JPEG && (targetWidth != 0 || targetHeight != 0))
+			{
+				//read just the header to find out how much smaller the JPEG decoder may go: it can scale by 1/2, 1/4 and 1/8
+				//while decoding, and picks the smallest of those that keeps both sides at least as big as the size hint
+				FIBITMAP * fiHeader = FreeImage_LoadFromMemory(format, fiMemory, FIF_LOAD_NOPIXELS);
+				if (fiHeader != nullptr)
+				{
+					sourceWidth = FreeImage_GetWidth(fiHeader);
+					sourceHeight = FreeImage_GetHeight(fiHeader);
+					FreeImage_Unload(fiHeader);
+
+					double scale = getCoverScale(sourceWidth, sourceHeight, targetWidth, targetHeight);
+					size_t sizeHint = (size_t)ceil(std::min(sourceWidth, sourceHeight) * scale);
+					if (scale <= 0.5 && sizeHint > 0 && sizeHint < 0x8000)
+						flags = (int)(sizeHint << 16);
+				}
+				FreeImage_SeekMemory(fiMemory, 0, SEEK_SET);
+			}
+#endif
 			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
+			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory, flags);
 			if (fiBitmap != nullptr)
 			{
 				//loaded. convert to 32bit if necessary
-				FIBITMAP * fiConverted = nullptr;
 				if (FreeImage_GetBPP(fiBitmap) != 32)
 				{
 					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
@@ -34,32 +309,34 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 				}
 				if (fiBitmap != nullptr)
 				{
-					width = FreeImage_GetWidth(fiBitmap);
-					height = FreeImage_GetHeight(fiBitmap);
-					unsigned int pitch = FreeImage_GetPitch(fiBitmap);
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-					unsigned char * tempData = new unsigned char[width * height * 4];
-					for (size_t i = 0; i < height; i++)
+					const size_t bitmapWidth = FreeImage_GetWidth(fiBitmap);
+					const size_t bitmapHeight = FreeImage_GetHeight(fiBitmap);
+					if (flags == 0)
 					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
+						sourceWidth = bitmapWidth;
+						sourceHeight = bitmapHeight;
 					}
-					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
+
+					//scale by the same factor in both directions, so the texture keeps the aspect ratio of the file
+					double scale = getCoverScale(sourceWidth, sourceHeight, targetWidth, targetHeight);
+					width = std::min(std::max((size_t)(sourceWidth * scale + 0.5), (size_t)1), bitmapWidth);
+					height = std::min(std::max((size_t)(sourceHeight * scale + 0.5), (size_t)1), bitmapHeight);
+
+					rawData.resize(width * height * 4);
+					if (width == bitmapWidth && height == bitmapHeight)
 					{
-						RGBQUAD bgra = ((RGBQUAD *)tempData)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
+						//convert scanline by scanline from BGRA to RGBA, right into the return vector
+						//this is necessary, because width*height*bpp might not be == pitch
+						for (size_t i = 0; i < height; i++)
+						{
+							const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, i);
+							convertToRGBA32(scanLine, rawData.data() + (i * width * 4), width);
+						}
+					}else{
+						downscaleBox(fiBitmap, rawData.data(), width, height);
 					}
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
 					//free bitmap data
 					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
 				}
 			}
 			else
@@ -74,5 +351,80 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 		//free FIMEMORY again
 		FreeImage_CloseMemory(fiMemory);
 	}
-	return rawData;
+	return !rawData.empty();
+}
+
+void ImageIO::benchmark()
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//a decoded 1920x1080 bitmap, with FreeImage's 4 byte line alignment
+	const size_t width = 1920;
+	const size_t height = 1080;
+	const size_t pitch = width * 4;
+	const double megapixels = (width * height) / 1000000.0;
+	const int runs = 50;
+
+	std::vector<unsigned char> bitmap(pitch * height);
+	for(size_t i = 0; i < bitmap.size(); i++)
+		bitmap[i] = (unsigned char)(i * 7 + (i >> 12));
+
+	volatile unsigned char sink = 0; //so the compiler can't drop the work
+
+	//before: copy the lines into a temporary buffer, swap one RGBQUAD at a time, copy everything into the vector
+	Clock::time_point start = Clock::now();
+	for(int run = 0; run < runs; run++)
+	{
+		unsigned char * tempData = new unsigned char[width * height * 4];
+		for(size_t i = 0; i < height; i++)
+			memcpy(tempData + (i * width * 4), &bitmap[i * pitch], width * 4);
+		for(size_t i = 0; i < width*height; i++)
+		{
+			RGBQUAD bgra = ((RGBQUAD *)tempData)[i];
+			RGBQUAD rgba;
+			rgba.rgbBlue = bgra.rgbRed;
+			rgba.rgbGreen = bgra.rgbGreen;
+			rgba.rgbRed = bgra.rgbBlue;
+			rgba.rgbReserved = bgra.rgbReserved;
+			((RGBQUAD *)tempData)[i] = rgba;
+		}
+		std::vector<unsigned char> rawData(tempData, tempData + width * height * 4);
+		delete[] tempData;
+		sink = sink + rawData[run];
+	}
+	const double before = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+
+	//after: one pass per line into the vector, scalar and vectorized
+	double after[2];
+	for(int vectorized = 0; vectorized < 2; vectorized++)
+	{
+		start = Clock::now();
+		for(int run = 0; run < runs; run++)
+		{
+			std::vector<unsigned char> rawData(width * height * 4);
+			for(size_t i = 0; i < height; i++)
+			{
+				if(vectorized)
+					convertToRGBA32(&bitmap[i * pitch], rawData.data() + (i * width * 4), width);
+				else
+					convertToRGBA32Scalar(&bitmap[i * pitch], rawData.data() + (i * width * 4), width);
+			}
+			sink = sink + rawData[run];
+		}
+		after[vectorized] = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+	}
+
+#if defined(IMAGEIO_USE_SSE2)
+	const char * simd = "SSE2";
+#elif defined(IMAGEIO_USE_NEON)
+	const char * simd = "NEON";
+#else
+	const char * simd = "none, scalar";
+#endif
+
+	std::cout << "BGRA to RGBA conversion of a " << width << "x" << height << " image, average of " << runs << " runs:\n";
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "copy, swap, copy (before):	" << before / megapixels << " ms/megapixel\n";
+	std::cout << "single pass, scalar:		" << after[0] / megapixels << " ms/megapixel\n";
+	std::cout << "single pass, vectorized:	" << after[1] / megapixels << " ms/megapixel (" << simd << ")\n";
 }
@@ -7,5 +7,43 @@
 class ImageIO
 {
 public:
+	//Layouts a decoded image can be packed into before it's uploaded. The 16 bit ones are native endian shorts, with
+	//the first channel in the highest bits, like OpenGL's GL_UNSIGNED_SHORT_5_6_5 and GL_UNSIGNED_SHORT_4_4_4_4.
+	enum PixelFormat
+	{
+		PIXEL_RGBA8888,
+		PIXEL_RGB565,
+		PIXEL_RGBA4444
+	};
+
+	static size_t getBytesPerPixel(PixelFormat format);
+
 	static std::vector<unsigned char> loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height);
-};
\ No newline at end of file
+
+	//Like above, but scaled down (never up) by the smallest factor that still covers targetWidth x targetHeight - an
+	//image with a lot more pixels than it's drawn with wastes decode time and video memory. 0 means any size, in both
+	//the whole image is loaded. JPEGs are decoded at a reduced size right away, a box filter takes care of the rest.
+	//sourceWidth/sourceHeight are set to the size of the image in the file.
+	static std::vector<unsigned char> loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t targetWidth, size_t targetHeight,
+		size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight);
+
+	//Like above, but decodes into imageRGBA (resized to width * height * 4, its memory is reused if it's big enough), so
+	//the pixels are written once, straight from FreeImage's bitmap. Returns false and leaves imageRGBA empty on errors.
+	static bool loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t targetWidth, size_t targetHeight,
+		std::vector<unsigned char> & imageRGBA, size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight);
+
+	//Converts pixels from FreeImage's 32 bit layout (BGRA on little endian machines) to RGBA, with SSE2 or NEON if the
+	//compiler targets them. src and dest may be the same.
+	static void convertToRGBA32(const unsigned char * src, unsigned char * dest, size_t pixels);
+
+	//True if no pixel of the RGBA image is (even partially) transparent.
+	static bool isOpaque(const unsigned char * imageRGBA, size_t pixels);
+
+	//Packs RGBA pixels into format, cutting off the low bits of every channel. dest may be the same as src, the packed
+	//image then takes up the start of the buffer.
+	static void packPixels(const unsigned char * src, unsigned char * dest, size_t pixels, PixelFormat format);
+
+	//Times converting a decoded image to RGBA the way loadFromMemoryRGBA32() used to (copy, swap, copy again) and the
+	//way it does now, and prints the cost per megapixel.
+	static void benchmark();
+};
@@ -0,0 +1,269 @@
+#include "LibraryWatcher.h"
+#include "SystemData.h"
+#include "DirectoryScanner.h"
+#include "Settings.h"
+#include "Log.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace
+{
+	//changes are handed out once no event arrived for this long...
+	const std::chrono::milliseconds QUIET_TIME(300);
+	//...or once the oldest one waited this long, so a long bulk copy still shows up bit by bit
+	const std::chrono::milliseconds MAX_DELAY(2000);
+
+#ifdef __linux__
+	const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+}
+
+LibraryWatcher* LibraryWatcher::sInstance = NULL;
+
+LibraryWatcher* LibraryWatcher::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new LibraryWatcher();
+
+	return sInstance;
+}
+
+LibraryWatcher::LibraryWatcher() : mFd(-1), mRunning(false)
+{
+}
+
+void LibraryWatcher::start(const std::vector<SystemData*>& systems)
+{
+	stop();
+
+	if(!Settings::getInstance()->getBool("WatchLibrary"))
+		return;
+
+#ifdef __linux__
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(mFd < 0)
+	{
+		LOG(LogWarning) << "Could not initialize inotify (" << strerror(errno) << "), new or removed games will show up after a restart";
+		return;
+	}
+
+	mRunning = true;
+	for(auto sys = systems.begin(); sys != systems.end() && mRunning; sys++)
+	{
+		const std::vector<std::string>& dirs = (*sys)->getScannedDirectories();
+		for(auto dir = dirs.begin(); dir != dirs.end() && mRunning; dir++)
+			addWatch(*sys, *dir);
+	}
+
+	if(!mRunning)
+	{
+		stop();
+		return;
+	}
+
+	LOG(LogInfo) << "Watching " << mWatches.size() << " ROM directories for changes";
+	mThread = std::thread(&LibraryWatcher::run, this);
+#endif
+}
+
+void LibraryWatcher::stop()
+{
+	mRunning = false;
+	if(mThread.joinable())
+		mThread.join();
+
+#ifdef __linux__
+	if(mFd >= 0)
+	{
+		close(mFd); //also removes every watch
+		mFd = -1;
+	}
+#endif
+
+	mWatches.clear();
+
+	std::lock_guard<std::mutex> lock(mPendingMutex);
+	mPending.clear();
+}
+
+std::vector<LibraryWatcher::Change> LibraryWatcher::takeChanges()
+{
+	std::vector<Change> changes;
+
+	std::lock_guard<std::mutex> lock(mPendingMutex);
+	if(mPending.empty())
+		return changes;
+
+	Clock::time_point now = Clock::now();
+	if(now - mLastPendingEvent < QUIET_TIME && now - mFirstPendingEvent < MAX_DELAY)
+		return changes;
+
+	//the set is sorted by path, so a new directory always comes before the things inside it
+	for(auto it = mPending.begin(); it != mPending.end(); it++)
+	{
+		Change change = { it->first, it->second };
+		changes.push_back(change);
+	}
+	mPending.clear();
+
+	return changes;
+}
+
+void LibraryWatcher::queueChange(SystemData* system, const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mPendingMutex);
+
+	Clock::time_point now = Clock::now();
+	if(mPending.empty())
+		mFirstPendingEvent = now;
+	mLastPendingEvent = now;
+
+	mPending.insert(std::make_pair(system, path));
+}
+
+void LibraryWatcher::disable(const std::string& reason)
+{
+	LOG(LogWarning) << reason << ", no longer watching ROM directories - new or removed games will show up after a restart";
+	mRunning = false;
+}
+
+void LibraryWatcher::addWatch(SystemData* system, const std::string& path)
+{
+#ifdef __linux__
+	int wd = inotify_add_watch(mFd, path.c_str(), WATCH_MASK);
+	if(wd < 0)
+	{
+		if(errno == ENOSPC)
+			disable("Reached the inotify watch limit (see /proc/sys/fs/inotify/max_user_watches)");
+		else if(errno == ENOMEM)
+			disable("Out of memory for inotify watches");
+		else
+			LOG(LogWarning) << "Could not watch \"" << path << "\" (" << strerror(errno) << ")";
+		return;
+	}
+
+	//two systems can share a directory, the kernel gives both the same watch
+	std::vector<WatchOwner>& owners = mWatches[wd];
+	for(auto it = owners.begin(); it != owners.end(); it++)
+	{
+		if(it->system == system && it->path == path)
+			return;
+	}
+
+	WatchOwner owner = { system, path };
+	owners.push_back(owner);
+#endif
+}
+
+void LibraryWatcher::addWatchRecursive(SystemData* system, const std::string& path)
+{
+	//no extensions - we only want the directories
+	DirectoryScanner scanner(std::vector<std::string>(), 1);
+	std::unique_ptr<DirectoryScanner::Directory> dir = scanner.scan(path);
+	if(!dir)
+		return;
+
+	std::vector<std::string> paths;
+	dir->collectPaths(paths);
+	for(auto it = paths.begin(); it != paths.end() && mRunning; it++)
+		addWatch(system, *it);
+}
+
+void LibraryWatcher::removeWatchRecursive(const std::string& path)
+{
+#ifdef __linux__
+	const std::string prefix = path + "/";
+
+	auto wd = mWatches.begin();
+	while(wd != mWatches.end())
+	{
+		std::vector<WatchOwner>& owners = wd->second;
+		auto owner = owners.begin();
+		while(owner != owners.end())
+		{
+			if(owner->path == path || owner->path.compare(0, prefix.length(), prefix) == 0)
+				owner = owners.erase(owner);
+			else
+				owner++;
+		}
+
+		if(owners.empty())
+		{
+			inotify_rm_watch(mFd, wd->first);
+			wd = mWatches.erase(wd);
+		}else{
+			wd++;
+		}
+	}
+#endif
+}
+
+void LibraryWatcher::run()
+{
+#ifdef __linux__
+	while(mRunning)
+	{
+		//wake up regularly to notice stop()
+		struct pollfd pfd = { mFd, POLLIN, 0 };
+		if(poll(&pfd, 1, 200) > 0)
+			readEvents();
+	}
+#endif
+}
+
+void LibraryWatcher::readEvents()
+{
+#ifdef __linux__
+	char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	ssize_t len;
+	while(mRunning && (len = read(mFd, buffer, sizeof(buffer))) > 0)
+	{
+		for(char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				LOG(LogWarning) << "Too many ROM directory changes at once, some will only show up after a restart";
+				continue;
+			}
+
+			if(event->mask & IN_IGNORED)
+			{
+				//the directory is gone (or its watch was removed)
+				mWatches.erase(event->wd);
+				continue;
+			}
+
+			auto watch = mWatches.find(event->wd);
+			if(watch == mWatches.end() || event->len == 0)
+				continue;
+
+			//copy, adding watches below may change the map
+			std::vector<WatchOwner> owners = watch->second;
+			for(auto owner = owners.begin(); owner != owners.end(); owner++)
+			{
+				std::string path = DirectoryScanner::joinPath(owner->path, event->name);
+
+				if(event->mask & IN_ISDIR)
+				{
+					if(event->mask & (IN_CREATE | IN_MOVED_TO))
+						addWatchRecursive(owner->system, path);
+					else if(event->mask & IN_MOVED_FROM)
+						removeWatchRecursive(path);
+				}
+
+				queueChange(owner->system, path);
+			}
+		}
+	}
+#endif
+}
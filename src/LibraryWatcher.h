@@ -0,0 +1,72 @@
+#ifndef _LIBRARYWATCHER_H_
+#define _LIBRARYWATCHER_H_
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+class SystemData;
+
+//Watches the ROM directories of every system for added, removed and renamed files (inotify, Linux only).
+//Events are collected on a background thread and coalesced per path; takeChanges() hands them to the main thread
+//once an event storm (like copying a few hundred ROMs) has settled, and SystemData::applyFileChange() brings the tree up to date.
+class LibraryWatcher
+{
+public:
+	struct Change
+	{
+		SystemData* system;
+		std::string path; //something at this path appeared, disappeared or was renamed
+	};
+
+	static LibraryWatcher* getInstance();
+
+	//Starts watching every directory the systems scanned. Does nothing if the "WatchLibrary" setting is off.
+	void start(const std::vector<SystemData*>& systems);
+
+	//Stops the background thread and forgets all pending changes. Must be called before the systems are deleted.
+	void stop();
+
+	//Returns the changes collected so far, if no new event arrived for a little while. Main thread only.
+	std::vector<Change> takeChanges();
+
+private:
+	LibraryWatcher();
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct WatchOwner
+	{
+		SystemData* system;
+		std::string path;
+	};
+
+	void run();
+	void readEvents();
+	void addWatch(SystemData* system, const std::string& path);
+	void addWatchRecursive(SystemData* system, const std::string& path);
+	void removeWatchRecursive(const std::string& path);
+	void queueChange(SystemData* system, const std::string& path);
+	void disable(const std::string& reason);
+
+	static LibraryWatcher* sInstance;
+
+	int mFd;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+
+	//only touched by the thread that owns the watches (the caller of start() until the thread runs)
+	std::map< int, std::vector<WatchOwner> > mWatches;
+
+	std::mutex mPendingMutex;
+	std::set< std::pair<SystemData*, std::string> > mPending;
+	Clock::time_point mFirstPendingEvent;
+	Clock::time_point mLastPendingEvent;
+};
+
+#endif
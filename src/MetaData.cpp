@@ -1,37 +1,65 @@
 #include "MetaData.h"
 #include "components/TextComponent.h"
 #include "Log.h"
+#include "BinaryIO.h"
 
 #include "components/TextEditComponent.h"
 #include "components/RatingComponent.h"
 #include "components/DateTimeComponent.h"
 #include <sstream>
+#include <cstdio>
 #include <cstring>
+#include <algorithm>
+#include <unordered_map>
 
-namespace 
+MetaDataList::MetaDataList() : mDirty(false), mGeneration(0)
 {
-        std::string genListIndexName(const std::string &key, unsigned int idx)
-        {
-                std::ostringstream ostr;
-                ostr << key << "#" << std::to_string(idx);
-                return ostr.str();
-        }
+	std::fill(mInts, mInts + INT_SLOTS, 0);
+	std::fill(mFloats, mFloats + FLOAT_SLOTS, 0.0f);
+	std::fill(mFixed, mFixed + FLOAT_SLOTS, false);
 }
 
-MetaDataList::MetaDataList()
+MetaDataList::MetaDataList(const std::vector<MetaDataDecl>& mdd) : mGeneration(0)
 {
-}
+	std::fill(mInts, mInts + INT_SLOTS, 0);
+	std::fill(mFloats, mFloats + FLOAT_SLOTS, 0.0f);
+	std::fill(mFixed, mFixed + FLOAT_SLOTS, false);
 
-MetaDataList::MetaDataList(const std::vector<MetaDataDecl>& mdd)
-{
 	for(auto iter = mdd.begin(); iter != mdd.end(); iter++)
                 if (iter->key != "image")
                         set(iter->key, iter->defaultValue);
+
+	//defaults aren't a change
+	mDirty = false;
+	mGeneration = 0;
 }
 
-std::vector<MetaDataDecl> MetaDataList::getDefaultGameMDD()
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
 {
-	MetaDataDecl decls[] = { 
+	std::copy(other.mStrings, other.mStrings + STRING_SLOTS, mStrings);
+	mList = other.mList;
+	std::copy(other.mInts, other.mInts + INT_SLOTS, mInts);
+	std::copy(other.mFloats, other.mFloats + FLOAT_SLOTS, mFloats);
+	std::copy(other.mTimes, other.mTimes + TIME_SLOTS, mTimes);
+	std::copy(other.mFixed, other.mFixed + FLOAT_SLOTS, mFixed);
+	mVerbatim = other.mVerbatim;
+	mExtra = other.mExtra;
+	mDirty = other.mDirty;
+
+	//not other's generation, a key taken from this list before could happen to match it
+	mGeneration++;
+	return *this;
+}
+
+unsigned int MetaDataList::getGeneration() const
+{
+	return mGeneration;
+}
+
+const std::vector<MetaDataDecl>& MetaDataList::getDefaultGameMDD()
+{
+	//the order has to match MetaDataField
+	static const MetaDataDecl decls[] = { 
 		{"name",		MD_STRING,				"", 		false,	false}, 
 		{"desc",		MD_MULTILINE_STRING,	"", 		false,	false},
 		{"image",		MD_IMAGE_PATH_LIST,			"", 		false,	false},
@@ -42,52 +70,126 @@ std::vector<MetaDataDecl> MetaDataList::getDefaultGameMDD()
 		{"lastplayed",	MD_TIME,				"0", 		true,	false},
 		{"selected",	MD_SELECTED,			"", 		true,	true}
 	};
+	static_assert(sizeof(decls) / sizeof(decls[0]) == MDF_COUNT, "getDefaultGameMDD() and MetaDataField don't match");
 
-	std::vector<MetaDataDecl> mdd(decls, decls + sizeof(decls) / sizeof(decls[0]));
+	static const std::vector<MetaDataDecl> mdd(decls, decls + sizeof(decls) / sizeof(decls[0]));
 	return mdd;
 }
 
+const MetaDataList::Slot& MetaDataList::getSlot(MetaDataField field)
+{
+	//has to match the types of getDefaultGameMDD()
+	static const Slot slots[] = {
+		{ STORE_STRING, 0 },	//name
+		{ STORE_STRING, 1 },	//desc
+		{ STORE_LIST, 0 },		//image
+		{ STORE_STRING, 2 },	//thumbnail
+		{ STORE_FLOAT, 0 },		//rating
+		{ STORE_TIME, 0 },		//releasedate
+		{ STORE_INT, 0 },		//playcount
+		{ STORE_TIME, 1 },		//lastplayed
+		{ STORE_TIME, 2 }		//selected
+	};
+	static_assert(sizeof(slots) / sizeof(slots[0]) == MDF_COUNT, "MetaDataList slots and MetaDataField don't match");
+
+	return slots[field];
+}
+
+MetaDataField MetaDataList::getField(const std::string& key)
+{
+	static const std::unordered_map<std::string, MetaDataField> fields = []() {
+		std::unordered_map<std::string, MetaDataField> map;
+		for(int i = 0; i < MDF_COUNT; i++)
+			map[getDefaultGameMDD()[i].key] = (MetaDataField)i;
+		return map;
+	}();
+
+	auto it = fields.find(key);
+	return it != fields.end() ? it->second : MDF_COUNT;
+}
+
+bool MetaDataList::isList(MetaDataField field)
+{
+	return getSlot(field).storage == STORE_LIST;
+}
+
+MetaDataField MetaDataList::getListField(const std::string& key)
+{
+	MetaDataField field = getField(key);
+	return (field != MDF_COUNT && isList(field)) ? field : MDF_COUNT;
+}
+
+unsigned int MetaDataList::getSize(MetaDataField field) const
+{
+	return mList.size();
+}
+
+const std::string &MetaDataList::getElemAt(MetaDataField field, unsigned int npos) const
+{
+	return mList.at(npos);
+}
+
+void MetaDataList::push_back(MetaDataField field, const std::string &value)
+{
+	mList.push_back(value);
+	mDirty = true;
+	mGeneration++;
+}
+
 unsigned int MetaDataList::getSize(const std::string &key) const
 {
-            const std::string keyWithSep(key + "#");
-            unsigned int size = std::count_if(
-                            mMap.begin(),
-                            mMap.end(),
-                            [&keyWithSep](const std::pair<std::string, std::string> &key_value){
-                                        return keyWithSep.size() < key_value.first.size() &&
-                                                std::strncmp(keyWithSep.c_str(), key_value.first.c_str(), keyWithSep.size()) == 0;
-                            }
-                        );
-            return size;
+        MetaDataField field = getListField(key);
+        return field != MDF_COUNT ? getSize(field) : 0;
 }
 
 const std::string &MetaDataList::getElemAt(const std::string &key, unsigned int npos) const
 {
-        const std::string &result = mMap.at(genListIndexName(key, npos));
-        return result;
+        MetaDataField field = getListField(key);
+        if (field == MDF_COUNT)
+                throw std::out_of_range("MetaData '" + key + "' is not a list");
+
+        return getElemAt(field, npos);
 }
 
 void MetaDataList::clearList(const std::string &key)
 {
-    const std::string keyWithSep(key+"#");
-    for (auto iter = mMap.begin(); iter != mMap.end();)
-    {
-        if (keyWithSep.compare(0, keyWithSep.size(), iter->first) == 0)
-            mMap.erase(iter++);
-        else
-            ++iter;
-    }
+        MetaDataField field = getListField(key);
+        if (field == MDF_COUNT)
+                return;
+
+        mList.clear();
+        mDirty = true;
+        mGeneration++;
 }
 
 void MetaDataList::push_back(const std::string &key, const std::string &value)
 {
-        const std::string newTailName = genListIndexName(key, getSize(key));
-        mMap[newTailName] = value;
+        MetaDataField field = getListField(key);
+        if (field == MDF_COUNT)
+        {
+                LOG(LogError) << "MetaData '" << key << "' is not a list, ignoring element \"" << value << "\"";
+                return;
+        }
+
+        push_back(field, value);
 }
 
 void MetaDataList::set(const std::string &key, unsigned int npos, const std::string &value)
 {
-    mMap[genListIndexName(key, npos)] = value;
+        MetaDataField field = getListField(key);
+        if (field == MDF_COUNT)
+        {
+                LOG(LogError) << "MetaData '" << key << "' is not a list, ignoring element \"" << value << "\"";
+                return;
+        }
+
+        std::vector<std::string>& list = mList;
+        if (npos >= list.size())
+                list.resize(npos + 1);
+
+        list[npos] = value;
+        mDirty = true;
+        mGeneration++;
 }
 
 MetaDataList MetaDataList::createFromXML(const std::vector<MetaDataDecl>& mdd, pugi::xml_node node)
@@ -102,96 +204,453 @@ MetaDataList MetaDataList::createFromXML(const std::vector<MetaDataDecl>& mdd, p
         }
         // overwrite settings from xml
         for (pugi::xml_node::iterator iter = node.begin(); iter != node.end(); ++iter)
-        {
-                if (std::string(iter->name()) == "image") 
-                        // multiple image tags possible
-                        mdl.push_back(iter->name(), iter->text().get());
-                else
-                        mdl.set(iter->name(), iter->text().get());
-        }
+                mdl.setFromTag(iter->name(), iter->text().get());
 
+	//this is what's on disk, nothing to save
+	mdl.mDirty = false;
+	mdl.mGeneration = 0;
 	return mdl;
 }
 
+void MetaDataList::setFromTag(const std::string& tag, const std::string& value)
+{
+        MetaDataField field = getListField(tag);
+        if (field != MDF_COUNT)
+                // multiple image tags possible
+                push_back(field, value);
+        else
+                set(tag, value);
+}
+
 void MetaDataList::appendToXML(pugi::xml_node parent, const std::vector<MetaDataDecl>& ignoreDefaults) const
 {
-	for(auto iter = mMap.begin(); iter != mMap.end(); iter++)
+	auto appendTag = [&](const std::string& key, const std::string& value)
 	{
-                std::string tagName;
 		for(auto mddIter = ignoreDefaults.begin(); mddIter != ignoreDefaults.end(); mddIter++)
 		{
-			if(mddIter->key == iter->first)
+			if(mddIter->key == key)
 			{
-                                if(iter->second != mddIter->defaultValue)
-                                        tagName = iter->first;
+                                if(value != mddIter->defaultValue)
+                                        parent.append_child(key.c_str()).text().set(value.c_str());
 				break;
-			} else if (mddIter->type == MD_IMAGE_PATH_LIST 
-                                        && mddIter->key.size() < iter->first.size()
-                                        && std::strncmp(mddIter->key.c_str(), iter->first.c_str(), mddIter->key.size()) == 0)
-                        {
-                                tagName = iter->first.substr(0, iter->first.find('#'));
-                                break;
-                        }
+			}
+		}
+	};
+
+	//every element of a list is its own tag, in order, and is always written (lists have no default)
+	auto appendList = [&](const std::string& key, const std::vector<std::string>& list)
+	{
+		for(auto mddIter = ignoreDefaults.begin(); mddIter != ignoreDefaults.end(); mddIter++)
+		{
+			if(mddIter->key == key)
+			{
+				for(auto elem = list.begin(); elem != list.end(); elem++)
+					parent.append_child(key.c_str()).text().set(elem->c_str());
+				break;
+			}
+		}
+	};
+
+	//tags are written sorted by key, the way they always were - so merge the slots (sorted once) with the extra keys
+	static const std::vector<MetaDataField> sortedFields = []() {
+		std::vector<MetaDataField> fields;
+		for(int i = 0; i < MDF_COUNT; i++)
+			fields.push_back((MetaDataField)i);
+
+		std::sort(fields.begin(), fields.end(), [](MetaDataField a, MetaDataField b) {
+			return getDefaultGameMDD()[a].key < getDefaultGameMDD()[b].key;
+		});
+		return fields;
+	}();
+
+	auto field = sortedFields.begin();
+	auto extra = mExtra.begin();
+	while(field != sortedFields.end() || extra != mExtra.end())
+	{
+		if(extra == mExtra.end() || (field != sortedFields.end() && getDefaultGameMDD()[*field].key < extra->first))
+		{
+			if(isList(*field))
+				appendList(getDefaultGameMDD()[*field].key, mList);
+			else
+				appendTag(getDefaultGameMDD()[*field].key, get(*field));
+			field++;
+		}else{
+			appendTag(extra->first, extra->second);
+			extra++;
+		}
+	}
+}
+
+//the shortest text that reads back as the same float ("0.8", not "0.800000"), or "%f" if fixed
+static std::string formatFloat(float value, bool fixed)
+{
+	char buffer[64];
+	if(fixed)
+	{
+		snprintf(buffer, sizeof(buffer), "%f", value);
+		return buffer;
+	}
+
+	for(int precision = 1; precision <= 9; precision++)
+	{
+		snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+		if((float)atof(buffer) == value)
+			break;
+	}
+	return buffer;
+}
+
+//special times (not_a_date_time, the infinities) don't have ticks, they're stored as their kind
+static void writeBinaryTime(std::string& out, const boost::posix_time::ptime& time)
+{
+	static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+	uint8_t special = time.is_not_a_date_time() ? 1 : time.is_pos_infinity() ? 2 : time.is_neg_infinity() ? 3 : 0;
+	writeBinaryValue<uint8_t>(out, special);
+	if(special == 0)
+		writeBinaryValue<int64_t>(out, (time - epoch).ticks());
+}
+
+static boost::posix_time::ptime readBinaryTime(BinaryReader& reader)
+{
+	static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+	switch(reader.read<uint8_t>())
+	{
+	case 0:
+		return epoch + boost::posix_time::time_duration(0, 0, 0, reader.read<int64_t>());
+	case 2:
+		return boost::posix_time::ptime(boost::posix_time::pos_infin);
+	case 3:
+		return boost::posix_time::ptime(boost::posix_time::neg_infin);
+	default:
+		return boost::posix_time::ptime();
+	}
+}
+
+void MetaDataList::writeBinary(std::string& out) const
+{
+	for(int i = 0; i < STRING_SLOTS; i++)
+		writeBinaryString(out, mStrings[i]);
+
+	writeBinaryValue<uint32_t>(out, (uint32_t)mList.size());
+	for(auto it = mList.begin(); it != mList.end(); it++)
+		writeBinaryString(out, *it);
+
+	for(int i = 0; i < INT_SLOTS; i++)
+		writeBinaryValue<int32_t>(out, mInts[i]);
+
+	for(int i = 0; i < FLOAT_SLOTS; i++)
+	{
+		writeBinaryValue<float>(out, mFloats[i]);
+		writeBinaryValue<uint8_t>(out, mFixed[i]);
+	}
+
+	for(int i = 0; i < TIME_SLOTS; i++)
+		writeBinaryTime(out, mTimes[i]);
+
+	writeBinaryValue<uint32_t>(out, (uint32_t)mVerbatim.size());
+	for(auto it = mVerbatim.begin(); it != mVerbatim.end(); it++)
+	{
+		writeBinaryValue<uint8_t>(out, (uint8_t)it->first);
+		writeBinaryString(out, it->second);
+	}
+
+	writeBinaryValue<uint32_t>(out, (uint32_t)mExtra.size());
+	for(auto it = mExtra.begin(); it != mExtra.end(); it++)
+	{
+		writeBinaryString(out, it->first);
+		writeBinaryString(out, it->second);
+	}
+}
+
+bool MetaDataList::readBinary(BinaryReader& reader)
+{
+	for(int i = 0; i < STRING_SLOTS; i++)
+		mStrings[i] = reader.readString();
+
+	mList.clear();
+	uint32_t listSize = reader.read<uint32_t>();
+	for(uint32_t i = 0; i < listSize && reader.ok(); i++)
+		mList.push_back(reader.readString());
+
+	for(int i = 0; i < INT_SLOTS; i++)
+		mInts[i] = reader.read<int32_t>();
+
+	for(int i = 0; i < FLOAT_SLOTS; i++)
+	{
+		mFloats[i] = reader.read<float>();
+		mFixed[i] = reader.read<uint8_t>() != 0;
+	}
+
+	for(int i = 0; i < TIME_SLOTS; i++)
+		mTimes[i] = readBinaryTime(reader);
+
+	mVerbatim.clear();
+	uint32_t verbatimCount = reader.read<uint32_t>();
+	for(uint32_t i = 0; i < verbatimCount && reader.ok(); i++)
+	{
+		uint8_t field = reader.read<uint8_t>();
+		std::string value = reader.readString();
+		if(field >= MDF_COUNT || isList((MetaDataField)field) || getSlot((MetaDataField)field).storage == STORE_STRING)
+			return false;
+
+		mVerbatim.push_back(std::make_pair((MetaDataField)field, value));
+	}
+
+	mExtra.clear();
+	uint32_t extraCount = reader.read<uint32_t>();
+	for(uint32_t i = 0; i < extraCount && reader.ok(); i++)
+	{
+		std::string key = reader.readString();
+		mExtra[key] = reader.readString();
+	}
+
+	mDirty = true;
+	mGeneration++;
+	return reader.ok();
+}
+
+void MetaDataList::setSlot(MetaDataField field, const std::string& value)
+{
+	const Slot& slot = getSlot(field);
+	switch(slot.storage)
+	{
+	case STORE_STRING:
+		mStrings[slot.index] = value;
+		break;
+	case STORE_INT:
+		mInts[slot.index] = atoi(value.c_str());
+		break;
+	case STORE_FLOAT:
+		mFloats[slot.index] = (float)atof(value.c_str());
+		mFixed[slot.index] = formatFloat(mFloats[slot.index], false) != value;
+		break;
+	case STORE_TIME:
+		//the defaults ("0" and "") don't parse, they're not_a_date_time
+		mTimes[slot.index] = string_to_ptime(value, "%Y%m%dT%H%M%S%F%q");
+		break;
+	case STORE_LIST:
+		break;
+	}
+
+	if(slot.storage == STORE_INT || slot.storage == STORE_FLOAT || slot.storage == STORE_TIME)
+		setVerbatim(field, format(field) != value ? &value : NULL);
+
+	changed(field);
+}
+
+void MetaDataList::changed(MetaDataField field)
+{
+	mDirty = true;
+
+	if(field != MDF_SELECTED)
+		mGeneration++;
+}
+
+std::string MetaDataList::format(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	switch(slot.storage)
+	{
+	case STORE_INT:
+		return std::to_string((long long)mInts[slot.index]);
+	case STORE_FLOAT:
+		return formatFloat(mFloats[slot.index], mFixed[slot.index]);
+	case STORE_TIME:
+		if(mTimes[slot.index].is_special())
+			return getDefaultGameMDD()[field].defaultValue;
+		return boost::posix_time::to_iso_string(mTimes[slot.index]);
+	default:
+		return "";
+	}
+}
+
+const std::string* MetaDataList::getVerbatim(MetaDataField field) const
+{
+	for(auto it = mVerbatim.begin(); it != mVerbatim.end(); it++)
+	{
+		if(it->first == field)
+			return &it->second;
+	}
+	return NULL;
+}
+
+void MetaDataList::setVerbatim(MetaDataField field, const std::string* value)
+{
+	for(auto it = mVerbatim.begin(); it != mVerbatim.end(); it++)
+	{
+		if(it->first == field)
+		{
+			if(value)
+				it->second = *value;
+			else
+				mVerbatim.erase(it);
+			return;
 		}
+	}
+
+	if(value)
+		mVerbatim.push_back(std::make_pair(field, *value));
+}
 
-		if(!tagName.empty())
-			parent.append_child(tagName.c_str()).text().set(iter->second.c_str());
+void MetaDataList::set(MetaDataField field, const std::string& value)
+{
+	if(isList(field))
+	{
+		LOG(LogWarning) << " Deprecation warning: MetaData for '" << getDefaultGameMDD()[field].key << "' is now of type list - using only first entry for backward compatibility";
+		set(getDefaultGameMDD()[field].key, 0, value);
+		return;
 	}
+
+	setSlot(field, value);
 }
 
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
-        if (key == "image")
+        MetaDataField field = getField(key);
+        if (field != MDF_COUNT)
         {
-                LOG(LogWarning) << " Deprecation warning: MetaData for '" << key << "' is now of type list - using only first entry for backward compatibility";
-                set(key, 0, value);
+                set(field, value);
         } else {
-                mMap[key] = value;
+                mExtra[key] = value;
+                mDirty = true;
+                mGeneration++;
         }
 }
 
 void MetaDataList::setTime(const std::string& key, const boost::posix_time::ptime& time)
 {
-	mMap[key] = boost::posix_time::to_iso_string(time);
-}
-
-const std::string& MetaDataList::get(const std::string& key) const
-{
-        try {
-                return mMap.at(key);
-        } catch (std::out_of_range &) {
-                // backward compatible access for lists (only returning first element)
-                if (getSize(key) > 0) {
-                        LOG(LogWarning) << " Deprecation warning: MetaData for '" << key << "' is now of type list - using only first entry for backward compatibility";
-                        return mMap.at(genListIndexName(key, 0));
-                }
-                // interface might have changed to list?
-                const std::vector<MetaDataDecl> mdd = getDefaultGameMDD();
-                for (const MetaDataDecl &m: mdd)
-                {
-                        if (m.key == key) {
-                                // type is list - but we have no value to return!
-                                // cannot return reference to temporary, so we define a constant value instead
-                                static const std::string emptyListValue;
-                                return emptyListValue;
-                        }
-                }
-                throw; // retrow
-        }
+	MetaDataField field = getField(key);
+	if(field != MDF_COUNT)
+		setTime(field, time);
+	else
+		set(key, boost::posix_time::to_iso_string(time));
+}
+
+void MetaDataList::setTime(MetaDataField field, const boost::posix_time::ptime& time)
+{
+	const Slot& slot = getSlot(field);
+	if(slot.storage != STORE_TIME)
+	{
+		set(field, boost::posix_time::to_iso_string(time));
+		return;
+	}
+
+	//no need to format and parse it again
+	mTimes[slot.index] = time;
+	setVerbatim(field, NULL);
+	changed(field);
+}
+
+bool MetaDataList::isDirty() const
+{
+	return mDirty;
+}
+
+void MetaDataList::setDirty(bool dirty)
+{
+	mDirty = dirty;
+}
+
+std::string MetaDataList::get(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	switch(slot.storage)
+	{
+	case STORE_STRING:
+		return mStrings[slot.index];
+	case STORE_INT:
+	case STORE_FLOAT:
+	case STORE_TIME:
+		{
+			const std::string* verbatim = getVerbatim(field);
+			return verbatim ? *verbatim : format(field);
+		}
+	case STORE_LIST:
+		break;
+	}
+
+	// backward compatible access for lists (only returning first element)
+	if(!mList.empty())
+	{
+		LOG(LogWarning) << " Deprecation warning: MetaData for '" << getDefaultGameMDD()[field].key << "' is now of type list - using only first entry for backward compatibility";
+		return mList.front();
+	}
+
+	// type is list - but we have no value to return!
+	return "";
+}
+
+const std::string& MetaDataList::getString(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	if(slot.storage != STORE_STRING)
+		throw std::logic_error("MetaData '" + getDefaultGameMDD()[field].key + "' is not stored as a string");
+
+	return mStrings[slot.index];
+}
+
+std::string MetaDataList::get(const std::string& key) const
+{
+        MetaDataField field = getField(key);
+        if (field != MDF_COUNT)
+                return get(field);
+
+        return mExtra.at(key);
+}
+
+int MetaDataList::getInt(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	if(slot.storage == STORE_INT)
+		return mInts[slot.index];
+
+	return atoi(get(field).c_str());
+}
+
+float MetaDataList::getFloat(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	if(slot.storage == STORE_FLOAT)
+		return mFloats[slot.index];
+
+	return (float)atof(get(field).c_str());
+}
+
+boost::posix_time::ptime MetaDataList::getTime(MetaDataField field) const
+{
+	const Slot& slot = getSlot(field);
+	if(slot.storage == STORE_TIME)
+		return mTimes[slot.index];
+
+	return string_to_ptime(get(field), "%Y%m%dT%H%M%S%F%q");
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
+	MetaDataField field = getField(key);
+	if(field != MDF_COUNT && !isList(field))
+		return getInt(field);
+
 	return atoi(get(key).c_str());
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
+	MetaDataField field = getField(key);
+	if(field != MDF_COUNT && !isList(field))
+		return getFloat(field);
+
 	return (float)atof(get(key).c_str());
 }
 
 boost::posix_time::ptime MetaDataList::getTime(const std::string& key) const
 {
+	MetaDataField field = getField(key);
+	if(field != MDF_COUNT && !isList(field))
+		return getTime(field);
+
 	return string_to_ptime(get(key), "%Y%m%dT%H%M%S%F%q");
 }
 
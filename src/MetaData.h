@@ -6,6 +6,8 @@
 #include "GuiComponent.h"
 #include <boost/date_time.hpp>
 
+class BinaryReader;
+
 enum MetaDataType
 {
 	//generic types
@@ -32,42 +34,144 @@ struct MetaDataDecl
         bool isInternal; //if true, hide in metadata editor
 };
 
+//The fields of getDefaultGameMDD(), in the same order. MetaDataList keeps one slot per field, so accessing them by
+//field doesn't need any lookup at all.
+enum MetaDataField
+{
+	MDF_NAME,
+	MDF_DESC,
+	MDF_IMAGE,
+	MDF_THUMBNAIL,
+	MDF_RATING,
+	MDF_RELEASEDATE,
+	MDF_PLAYCOUNT,
+	MDF_LASTPLAYED,
+	MDF_SELECTED,
+
+	MDF_COUNT
+};
+
 boost::posix_time::ptime string_to_ptime(const std::string& str, const std::string& fmt = "%Y%m%dT%H%M%S%F%q");
 
 class MetaDataList
 {
 public:
-	static std::vector<MetaDataDecl> getDefaultGameMDD();
+	static const std::vector<MetaDataDecl>& getDefaultGameMDD();
+
+	//returns the slot of key, or MDF_COUNT if key is not part of the default schema
+	static MetaDataField getField(const std::string& key);
 
 	static MetaDataList createFromXML(const std::vector<MetaDataDecl>& mdd, pugi::xml_node node);
 
 	//MetaDataDecl required to set our defaults.
 	MetaDataList(const std::vector<MetaDataDecl>& mdd);
 
-        // accessor methods for list values (i.e. images)
+	//counts as a change of the target (see getGeneration())
+	MetaDataList& operator=(const MetaDataList& other);
+
+	//Increased by every change to this list, except for the selection time (which changes with every cursor move) - setting
+	//the defaults while constructing or loading a list doesn't count. Anything derived from a game's metadata (like its
+	//sort key) can remember this and know it's still valid as long as it doesn't change.
+	unsigned int getGeneration() const;
+
+        // accessor methods for list values (i.e. images), only MD_IMAGE_PATH_LIST fields have any elements
         unsigned int getSize(const std::string &key) const;
         const std::string &getElemAt(const std::string &key, unsigned int pos) const;
         void clearList(const std::string &key);
         void push_back(const std::string &key, const std::string &value);
         void set(const std::string &key, unsigned int npos, const std::string &value);
 
+        unsigned int getSize(MetaDataField field) const;
+        const std::string &getElemAt(MetaDataField field, unsigned int pos) const;
+        void push_back(MetaDataField field, const std::string &value);
+
 	void set(const std::string& key, const std::string& value);
-	void setTime(const std::string& key, const boost::posix_time::ptime& time); //times are internally stored as ISO strings (e.g. boost::posix_time::to_iso_string(ptime))
+	void setTime(const std::string& key, const boost::posix_time::ptime& time); //stored as is, formatted with boost::posix_time::to_iso_string()
 
-	const std::string& get(const std::string& key) const;
+	//numbers and times are formatted here, they aren't kept as strings - unless they were set from text that doesn't
+	//format back the same (like "007" or a date in another format), which is returned as it was
+	std::string get(const std::string& key) const;
 	int getInt(const std::string& key) const;
 	float getFloat(const std::string& key) const;
 	boost::posix_time::ptime getTime(const std::string& key) const;
 
+	//same as above, without looking up the key
+	void set(MetaDataField field, const std::string& value);
+	void setTime(MetaDataField field, const boost::posix_time::ptime& time);
+	std::string get(MetaDataField field) const;
+	const std::string& getString(MetaDataField field) const; //only for fields stored as strings (name, desc, thumbnail)
+	int getInt(MetaDataField field) const;
+	float getFloat(MetaDataField field) const;
+	boost::posix_time::ptime getTime(MetaDataField field) const;
+
 	static GuiComponent* makeDisplay(Window* window, MetaDataType as);
 	static GuiComponent* makeEditor(Window* window, MetaDataType as);
 
+	//applies one <tag>value</tag> of a gamelist entry, the way createFromXML does
+	void setFromTag(const std::string& tag, const std::string& value);
+
 	void appendToXML(pugi::xml_node parent, const std::vector<MetaDataDecl>& ignoreDefaults = std::vector<MetaDataDecl>()) const;
 
+	//The values as they're stored, for the gamelist cache - reading them back doesn't parse anything. readBinary()
+	//replaces the whole list (a change, like operator=) and returns false if the data is broken.
+	void writeBinary(std::string& out) const;
+	bool readBinary(BinaryReader& reader);
+
+	//true if anything was changed since the list was constructed/loaded (or since the last setDirty(false)), copies keep the flag
+	bool isDirty() const;
+	void setDirty(bool dirty);
+
 private:
 	MetaDataList();
 
-	std::map<std::string, std::string> mMap;
+	//Every field of the schema is kept in its native form, in the array for its kind of value - strings are parsed
+	//when they're set and only formatted again by get() and appendToXML(). Text that wouldn't come out the same when
+	//formatted again is also kept, in mVerbatim, so the gamelist is written back exactly as it was read.
+	enum Storage
+	{
+		STORE_STRING,
+		STORE_LIST,
+		STORE_INT,
+		STORE_FLOAT,
+		STORE_TIME
+	};
+
+	struct Slot
+	{
+		Storage storage;
+		int index; //into the array of storage
+	};
+
+	static const int STRING_SLOTS = 3; //name, desc, thumbnail
+	static const int INT_SLOTS = 1; //playcount
+	static const int FLOAT_SLOTS = 1; //rating
+	static const int TIME_SLOTS = 3; //releasedate, lastplayed, selected
+
+	static const Slot& getSlot(MetaDataField field);
+
+	void setSlot(MetaDataField field, const std::string& value);
+	void changed(MetaDataField field);
+
+	//the value of a number or time field, formatted - ignoring mVerbatim
+	std::string format(MetaDataField field) const;
+	const std::string* getVerbatim(MetaDataField field) const;
+	void setVerbatim(MetaDataField field, const std::string* value); //NULL removes it
+
+	//returns the field of key if it is a list, MDF_COUNT otherwise
+	static MetaDataField getListField(const std::string& key);
+	static bool isList(MetaDataField field);
+
+
+	std::string mStrings[STRING_SLOTS];
+	std::vector<std::string> mList; //the elements of the one MD_IMAGE_PATH_LIST field, in order
+	int mInts[INT_SLOTS];
+	float mFloats[FLOAT_SLOTS];
+	boost::posix_time::ptime mTimes[TIME_SLOTS]; //not_a_date_time for the default ("0" or "")
+	bool mFixed[FLOAT_SLOTS]; //formatted with "%f" (like the default "0.000000") instead of as short as possible
+	std::vector<std::pair<MetaDataField, std::string> > mVerbatim; //usually empty
+	std::map<std::string, std::string> mExtra; //keys that aren't in the schema (unknown tags)
+	bool mDirty;
+	unsigned int mGeneration;
 };
 
 
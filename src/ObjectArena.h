@@ -0,0 +1,86 @@
+#ifndef _OBJECTARENA_H_
+#define _OBJECTARENA_H_
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+//Allocates objects of one type in blocks, instead of one heap allocation per object.
+//Objects that are destroyed leave a hole that the next create() fills. clear() (and the destructor) runs the
+//destructors of everything still alive block by block and releases the blocks in one go - much faster than deleting
+//a big tree node by node, and the objects of a tree built in one go end up next to each other in memory.
+//Not thread safe.
+template<typename T>
+class ObjectArena
+{
+public:
+	ObjectArena() : mUsedInLastBlock(BLOCK_SIZE) {}
+	~ObjectArena() { clear(); }
+
+	template<typename... Args>
+	T* create(Args&&... args)
+	{
+		void* slot;
+		if(!mFree.empty())
+		{
+			slot = mFree.back();
+			mFree.pop_back();
+		}else{
+			if(mUsedInLastBlock == BLOCK_SIZE)
+			{
+				mBlocks.push_back(std::unique_ptr<Block>(new Block()));
+				mUsedInLastBlock = 0;
+			}
+
+			slot = &mBlocks.back()->slots[mUsedInLastBlock++];
+		}
+
+		return new(slot) T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* object)
+	{
+		object->~T();
+		mFree.push_back(object);
+	}
+
+	void clear()
+	{
+		//everything that isn't in the free list is alive
+		std::sort(mFree.begin(), mFree.end());
+
+		for(unsigned int i = 0; i < mBlocks.size(); i++)
+		{
+			unsigned int used = (i + 1 == mBlocks.size()) ? mUsedInLastBlock : BLOCK_SIZE;
+			for(unsigned int j = 0; j < used; j++)
+			{
+				T* object = reinterpret_cast<T*>(&mBlocks[i]->slots[j]);
+				if(!std::binary_search(mFree.begin(), mFree.end(), (void*)object))
+					object->~T();
+			}
+		}
+
+		mBlocks.clear();
+		mFree.clear();
+		mUsedInLastBlock = BLOCK_SIZE;
+	}
+
+private:
+	ObjectArena(const ObjectArena&);
+	ObjectArena& operator=(const ObjectArena&);
+
+	static const unsigned int BLOCK_SIZE = 256;
+
+	struct Block
+	{
+		typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type slots[BLOCK_SIZE];
+	};
+
+	std::vector< std::unique_ptr<Block> > mBlocks;
+	unsigned int mUsedInLastBlock;
+	std::vector<void*> mFree;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "PlayedGamesFolder.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include <algorithm>
+
+PlayedGamesFolder* PlayedGamesFolder::sInstances[2] = { NULL, NULL };
+
+namespace
+{
+	size_t getCapacitySetting()
+	{
+		int capacity = Settings::getInstance()->getInt("PlayedCollectionSize");
+		return capacity > 0 ? (size_t)capacity : 0;
+	}
+}
+
+PlayedGamesFolder* PlayedGamesFolder::getInstance(Order order)
+{
+	if(sInstances[order] == NULL)
+	{
+		if(order == RECENTLY_PLAYED)
+			sInstances[order] = new PlayedGamesFolder(order, "recentlyplayed", "Recently Played");
+		else
+			sInstances[order] = new PlayedGamesFolder(order, "mostplayed", "Most Played");
+	}
+
+	return sInstances[order];
+}
+
+PlayedGamesFolder::PlayedGamesFolder(Order order, const std::string& path, const std::string& name)
+	: FolderData(NULL, path, name), mOrder(order), mCapacity(getCapacitySetting()), mRefill(false)
+{
+}
+
+void PlayedGamesFolder::restore(const std::vector<SystemData*>& systems)
+{
+	PlayedGamesFolder* recent = getInstance(RECENTLY_PLAYED);
+	PlayedGamesFolder* most = getInstance(MOST_PLAYED);
+	recent->clear();
+	most->clear();
+	recent->mCapacity = most->mCapacity = getCapacitySetting();
+
+	for(auto it = systems.begin(); it != systems.end(); it++)
+	{
+		SystemData* system = *it;
+		system->getRootFolder()->visitGames([system, recent, most](GameData* game) {
+			recent->offer(system, game);
+			most->offer(system, game);
+		});
+	}
+}
+
+void PlayedGamesFolder::gamePlayed(SystemData* system, GameData* game)
+{
+	getInstance(RECENTLY_PLAYED)->offer(system, game);
+	getInstance(MOST_PLAYED)->offer(system, game);
+}
+
+void PlayedGamesFolder::gameRemoved(GameData* game)
+{
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		if(sInstances[i])
+			sInstances[i]->remove(game);
+	}
+}
+
+void PlayedGamesFolder::clearAll()
+{
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		if(sInstances[i])
+			sInstances[i]->clear();
+	}
+}
+
+bool PlayedGamesFolder::getKey(GameData* game, int64_t& key) const
+{
+	MetaDataList* metadata = game->metadata();
+	if(mOrder == MOST_PLAYED)
+	{
+		key = metadata->getInt(MDF_PLAYCOUNT);
+		return key > 0;
+	}
+
+	static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	boost::posix_time::ptime lastPlayed = metadata->getTime(MDF_LASTPLAYED);
+	if(lastPlayed.is_special())
+		return false;
+
+	key = (lastPlayed - epoch).total_seconds();
+	return true;
+}
+
+//ties go to the game with the smaller name, so the collection doesn't depend on the order games were offered in
+bool PlayedGamesFolder::isWorse(const Item& a, const Item& b)
+{
+	if(a.key != b.key)
+		return a.key < b.key;
+	return a.game->getName() > b.game->getName();
+}
+
+void PlayedGamesFolder::swapItems(size_t a, size_t b)
+{
+	std::swap(mHeap[a], mHeap[b]);
+	mPositions[mHeap[a].game] = a;
+	mPositions[mHeap[b].game] = b;
+}
+
+void PlayedGamesFolder::siftUp(size_t i)
+{
+	while(i > 0)
+	{
+		size_t parent = (i - 1) / 2;
+		if(!isWorse(mHeap[i], mHeap[parent]))
+			break;
+		swapItems(i, parent);
+		i = parent;
+	}
+}
+
+void PlayedGamesFolder::siftDown(size_t i)
+{
+	while(true)
+	{
+		size_t worst = i;
+		size_t left = 2 * i + 1, right = 2 * i + 2;
+		if(left < mHeap.size() && isWorse(mHeap[left], mHeap[worst]))
+			worst = left;
+		if(right < mHeap.size() && isWorse(mHeap[right], mHeap[worst]))
+			worst = right;
+		if(worst == i)
+			break;
+		swapItems(i, worst);
+		i = worst;
+	}
+}
+
+void PlayedGamesFolder::offer(SystemData* system, GameData* game)
+{
+	Item item = { 0, game, system };
+	bool belongs = getKey(game, item.key);
+
+	auto found = mPositions.find(game);
+	if(found != mPositions.end())
+	{
+		if(!belongs)
+		{
+			remove(game);
+			return;
+		}
+
+		//already in, move it to where its new key belongs
+		size_t i = found->second;
+		mHeap[i].key = item.key;
+		siftUp(i);
+		siftDown(mPositions[game]);
+		return;
+	}
+
+	if(!belongs)
+		return;
+
+	if(mHeap.size() < mCapacity)
+	{
+		mHeap.push_back(item);
+		mPositions[game] = mHeap.size() - 1;
+		siftUp(mHeap.size() - 1);
+	}else if(!mHeap.empty() && isWorse(mHeap.front(), item))
+	{
+		//replaces the worst game
+		mPositions.erase(mHeap.front().game);
+		mHeap.front() = item;
+		mPositions[game] = 0;
+		siftDown(0);
+	}
+}
+
+void PlayedGamesFolder::remove(GameData* game)
+{
+	auto found = mPositions.find(game);
+	if(found == mPositions.end())
+		return;
+
+	//the best game that didn't make it would take its place, but only a restore knows which one that is
+	if(mHeap.size() >= mCapacity)
+		mRefill = true;
+
+	size_t i = found->second;
+	size_t last = mHeap.size() - 1;
+	if(i != last)
+		swapItems(i, last);
+
+	mPositions.erase(game);
+	mHeap.pop_back();
+
+	if(i < mHeap.size())
+	{
+		//the last game took its place, it may belong above or below it
+		GameData* moved = mHeap[i].game;
+		siftUp(i);
+		siftDown(mPositions[moved]);
+	}
+}
+
+void PlayedGamesFolder::clear()
+{
+	mHeap.clear();
+	mPositions.clear();
+	mRefill = false;
+	setFiles(std::vector<FileData*>());
+}
+
+void PlayedGamesFolder::sort(ComparisonFunction & comparisonFunction, bool ascending)
+{
+	if(mRefill)
+		restore(SystemData::sSystemVector);
+
+	std::vector<Item> items = mHeap;
+	std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return isWorse(b, a); });
+
+	std::vector<FileData*> files;
+	files.reserve(items.size());
+	for(auto it = items.begin(); it != items.end(); it++)
+		files.push_back(it->game);
+
+	setFiles(files);
+}
+
+SystemData* PlayedGamesFolder::getSystem(GameData* game) const
+{
+	auto found = mPositions.find(game);
+	return found == mPositions.end() ? NULL : mHeap[found->second].system;
+}
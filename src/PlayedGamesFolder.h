@@ -0,0 +1,71 @@
+#ifndef _PLAYEDGAMESFOLDER_H_
+#define _PLAYEDGAMESFOLDER_H_
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "FolderData.h"
+
+class SystemData;
+
+//The games played most recently or most often, across all systems: a virtual folder that keeps only the top few
+//(the "PlayedCollectionSize" setting) in a bounded min-heap - the root is the game that drops out next.
+//SystemData::launchGame offers every game it launched, which costs O(log size); nothing is ever sorted as a whole.
+//It always shows its games best first, whatever sort order is asked for.
+//The heap doesn't know the games below the cutoff: once a game is removed from a full collection, the next sort()
+//restores both collections, so the next best game takes its place.
+class PlayedGamesFolder : public FolderData
+{
+public:
+	enum Order
+	{
+		RECENTLY_PLAYED,
+		MOST_PLAYED
+	};
+
+	static PlayedGamesFolder* getInstance(Order order);
+
+	//Restores both collections from the metadata of every game, one heap operation per game at most. Reads the
+	//"PlayedCollectionSize" setting again.
+	static void restore(const std::vector<SystemData*>& systems);
+	//Call after game was played; updates both collections.
+	static void gamePlayed(SystemData* system, GameData* game);
+	//Call before game is destroyed.
+	static void gameRemoved(GameData* game);
+	static void clearAll();
+
+	void sort(ComparisonFunction & comparisonFunction = compareFileName, bool ascending = true) override;
+	SystemData* getSystem(GameData* game) const override;
+
+private:
+	PlayedGamesFolder(Order order, const std::string& path, const std::string& name);
+
+	struct Item
+	{
+		int64_t key;
+		GameData* game;
+		SystemData* system;
+	};
+
+	//the key the collection is ordered by, false if game doesn't belong in it at all (it was never played)
+	bool getKey(GameData* game, int64_t& key) const;
+
+	void offer(SystemData* system, GameData* game);
+	void remove(GameData* game);
+	void clear();
+
+	static bool isWorse(const Item& a, const Item& b);
+	void siftUp(size_t i);
+	void siftDown(size_t i);
+	void swapItems(size_t a, size_t b);
+
+	static PlayedGamesFolder* sInstances[2];
+
+	Order mOrder;
+	size_t mCapacity;
+	bool mRefill; //a game was removed while the collection was full, see sort()
+	std::vector<Item> mHeap; //min-heap, the worst game is at the root
+	std::unordered_map<GameData*, size_t> mPositions; //game -> index in mHeap
+};
+
+#endif
@@ -38,6 +38,12 @@ namespace Renderer
 	void setMatrix(const Eigen::Affine3f& transform);
 
 	void drawRect(int x, int y, int w, int h, unsigned int color);
+
+	//Binds texture to GL_TEXTURE_2D, unless it's bound already - small images share atlas textures, so most binds are
+	//redundant. Textures must be bound and deleted through these, or the remembered binding goes stale.
+	void bindTexture(GLuint texture);
+	void deleteTexture(GLuint texture);
+	void resetTextureBinding(); //forgets the bound texture, e.g. when the GL context is recreated
 }
 
 #endif
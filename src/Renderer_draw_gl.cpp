@@ -9,6 +9,7 @@
 
 namespace Renderer {
 	std::stack<Eigen::Vector4i> clipStack;
+	GLuint boundTexture = 0;
 
 	void setColor4bArray(GLubyte* array, unsigned int color)
 	{
@@ -117,4 +118,27 @@ namespace Renderer {
 	{
 		setMatrix((float*)matrix.data());
 	}
+
+	void bindTexture(GLuint texture)
+	{
+		if(texture == boundTexture)
+			return;
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		boundTexture = texture;
+	}
+
+	void deleteTexture(GLuint texture)
+	{
+		//GL unbinds it, and the name may be handed out again
+		if(texture == boundTexture)
+			boundTexture = 0;
+
+		glDeleteTextures(1, &texture);
+	}
+
+	void resetTextureBinding()
+	{
+		boundTexture = 0;
+	}
 };
@@ -7,9 +7,11 @@ namespace Renderer
 {
 	void onInit()
 	{
+		resetTextureBinding();
 	}
 
 	void onDeinit()
 	{
+		resetTextureBinding();
 	}
 };
@@ -0,0 +1,144 @@
+#include "ScanCache.h"
+#include "Log.h"
+#include "BinaryIO.h"
+#include <ctime>
+#include <sys/stat.h>
+
+namespace
+{
+	const char CACHE_MAGIC[4] = { 'E', 'S', 'S', 'C' };
+	const uint32_t CACHE_VERSION = 1;
+
+	//listings stamped this close to the scan that saved them are never trusted -
+	//a change right after that scan may not have moved a coarse (FAT, SMB) mtime at all
+	const int64_t MTIME_SLACK = 2;
+}
+
+ScanCache::ScanCache() : mLoadedScanTime(0), mScanTime((int64_t)time(NULL)), mHits(0), mMisses(0)
+{
+}
+
+bool ScanCache::getStamp(const std::string& path, Stamp& stamp)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+		return false;
+
+	stamp.mtimeSec = (int64_t)st.st_mtime;
+#if defined(__linux__)
+	stamp.mtimeNsec = (int64_t)st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+	stamp.mtimeNsec = (int64_t)st.st_mtimespec.tv_nsec;
+#else
+	stamp.mtimeNsec = 0;
+#endif
+	stamp.inode = (uint64_t)st.st_ino;
+	return true;
+}
+
+bool ScanCache::lookup(const std::string& dir, const Stamp& stamp, std::vector<RawEntry>& entries)
+{
+	auto it = mLoaded.find(dir);
+	if(it == mLoaded.end()
+		|| it->second.stamp.mtimeSec != stamp.mtimeSec
+		|| it->second.stamp.mtimeNsec != stamp.mtimeNsec
+		|| it->second.stamp.inode != stamp.inode
+		|| it->second.stamp.mtimeSec >= mLoadedScanTime - MTIME_SLACK)
+	{
+		mMisses++;
+		return false;
+	}
+
+	entries = it->second.entries;
+	mHits++;
+	return true;
+}
+
+void ScanCache::store(const std::string& dir, const Stamp& stamp, const std::vector<RawEntry>& entries)
+{
+	std::lock_guard<std::mutex> lock(mStoredMutex);
+	Listing& listing = mStored[dir];
+	listing.stamp = stamp;
+	listing.entries = entries;
+}
+
+bool ScanCache::load(const std::string& path)
+{
+	mLoaded.clear();
+
+	MappedFile file;
+	if(!file.open(path))
+		return false;
+
+	BinaryReader reader(file.data(), file.size());
+	if(!reader.readMagic(CACHE_MAGIC, sizeof(CACHE_MAGIC)))
+	{
+		LOG(LogWarning) << "Scan cache \"" << path << "\" is not a scan cache, ignoring it";
+		return false;
+	}
+
+	if(reader.read<uint32_t>() != CACHE_VERSION)
+	{
+		LOG(LogInfo) << "Scan cache \"" << path << "\" was written by a different version, ignoring it";
+		return false;
+	}
+
+	int64_t scanTime = reader.read<int64_t>();
+	uint32_t dirCount = reader.read<uint32_t>();
+
+	ListingMap loaded;
+	for(uint32_t i = 0; i < dirCount && reader.ok(); i++)
+	{
+		std::string dir = reader.readString();
+		Listing& listing = loaded[dir];
+		listing.stamp.mtimeSec = reader.read<int64_t>();
+		listing.stamp.mtimeNsec = reader.read<int64_t>();
+		listing.stamp.inode = reader.read<uint64_t>();
+
+		uint32_t entryCount = reader.read<uint32_t>();
+		for(uint32_t j = 0; j < entryCount && reader.ok(); j++)
+		{
+			RawEntry entry;
+			entry.type = (EntryType)reader.read<uint8_t>();
+			entry.name = reader.readString();
+			listing.entries.push_back(entry);
+		}
+	}
+
+	if(!reader.ok() || !reader.atEnd())
+	{
+		LOG(LogWarning) << "Scan cache \"" << path << "\" is corrupt, ignoring it";
+		return false;
+	}
+
+	mLoaded.swap(loaded);
+	mLoadedScanTime = scanTime;
+	return true;
+}
+
+bool ScanCache::save(const std::string& path)
+{
+	std::string data;
+	data.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeBinaryValue<uint32_t>(data, CACHE_VERSION);
+	writeBinaryValue<int64_t>(data, mScanTime);
+
+	std::lock_guard<std::mutex> lock(mStoredMutex);
+	writeBinaryValue<uint32_t>(data, (uint32_t)mStored.size());
+	for(auto it = mStored.begin(); it != mStored.end(); it++)
+	{
+		writeBinaryString(data, it->first);
+		writeBinaryValue<int64_t>(data, it->second.stamp.mtimeSec);
+		writeBinaryValue<int64_t>(data, it->second.stamp.mtimeNsec);
+		writeBinaryValue<uint64_t>(data, it->second.stamp.inode);
+
+		writeBinaryValue<uint32_t>(data, (uint32_t)it->second.entries.size());
+		for(auto entry = it->second.entries.begin(); entry != it->second.entries.end(); entry++)
+		{
+			writeBinaryValue<uint8_t>(data, (uint8_t)entry->type);
+			writeBinaryString(data, entry->name);
+		}
+	}
+
+	return writeFileAtomically(path, data);
+}
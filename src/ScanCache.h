@@ -0,0 +1,78 @@
+#ifndef _SCANCACHE_H_
+#define _SCANCACHE_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+//Remembers the listing of every directory a DirectoryScanner read, keyed by the directory's mtime and inode.
+//On the next start, directories whose stamp didn't change reuse the old listing instead of being read again.
+//Listings are stored unfiltered, so changing a system's extensions doesn't need a rescan.
+class ScanCache
+{
+public:
+	enum EntryType
+	{
+		ENTRY_UNKNOWN,
+		ENTRY_FILE,
+		ENTRY_DIRECTORY,
+		ENTRY_SYMLINK
+	};
+
+	struct RawEntry
+	{
+		std::string name;
+		EntryType type;
+	};
+
+	struct Stamp
+	{
+		int64_t mtimeSec;
+		int64_t mtimeNsec;
+		uint64_t inode;
+	};
+
+	ScanCache();
+
+	//Loads the listings saved by a previous scan. Returns false (and starts empty) if the file is missing or invalid.
+	bool load(const std::string& path);
+
+	//Writes every listing stored during this scan. Directories that weren't visited this time are dropped.
+	bool save(const std::string& path);
+
+	//Gets the stamp of the directory at path (following symlinks). Returns false if it can't be stat'd.
+	static bool getStamp(const std::string& path, Stamp& stamp);
+
+	//Fills entries with the loaded listing of dir if its stamp still matches. Safe to call from several threads.
+	bool lookup(const std::string& dir, const Stamp& stamp, std::vector<RawEntry>& entries);
+
+	//Remembers the current listing of dir for the next save. Safe to call from several threads.
+	void store(const std::string& dir, const Stamp& stamp, const std::vector<RawEntry>& entries);
+
+	unsigned int getHits() const { return mHits; }
+	unsigned int getMisses() const { return mMisses; }
+
+private:
+	struct Listing
+	{
+		Stamp stamp;
+		std::vector<RawEntry> entries;
+	};
+
+	typedef std::unordered_map<std::string, Listing> ListingMap;
+
+	ListingMap mLoaded; //read-only while scanning
+	int64_t mLoadedScanTime;
+
+	std::mutex mStoredMutex;
+	ListingMap mStored;
+	int64_t mScanTime;
+
+	std::atomic<unsigned int> mHits;
+	std::atomic<unsigned int> mMisses;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "Settings.h"
 #include <signal.h>
 #include "Log.h"
+#include "GamelistWriter.h"
 
 std::ostream& out = std::cout;
 
@@ -15,6 +16,7 @@ void handle_interrupt_signal(int p)
 	LOG(LogInfo) << "Interrupt received during scrape...";
 
 	SystemData::deleteSystems();
+	GamelistWriter::getInstance()->stop();
 
 	exit(1);
 }
@@ -157,7 +159,7 @@ int run_scraper_cmdline()
 			//need to take into account filter_choice
 			if(filter_choice == FILTER_MISSING_IMAGES)
 			{
-				if(params.game->metadata()->getSize("image") != 0) //maybe should also check if the image file exists/is a URL
+				if(params.game->metadata()->getSize(MDF_IMAGE) != 0) //maybe should also check if the image file exists/is a URL
 				{
 					out << "   Skipping, metadata \"image\" entry is not empty.\n";
 					continue;
@@ -229,6 +231,8 @@ int run_scraper_cmdline()
 
 			} while(true);
 
+			params.system->updateSearchIndex(params.game);
+
 			out << "===================\n";
 		}
 	}
@@ -243,7 +247,7 @@ int run_scraper_cmdline()
 		for(auto gameIt = files.begin(); gameIt != files.end(); gameIt++)
 		{
 			GameData* game = (GameData*)(*gameIt);
-			std::vector<MetaDataDecl> mdd = (*sysIt)->getGameMDD();
+			const std::vector<MetaDataDecl>& mdd = (*sysIt)->getGameMDD();
 			for(auto i = mdd.begin(); i != mdd.end(); i++)
 			{
 				std::string key = i->key;
@@ -35,12 +35,25 @@ void Settings::setDefaults()
 	mBoolMap["DISABLESOUNDS"] = false;
 	mBoolMap["DisableGamelistWrites"] = false;
 	mBoolMap["ScrapeRatings"] = true;
+	mBoolMap["ForceRescan"] = false;
+	mBoolMap["WatchLibrary"] = true;
+	mBoolMap["TexturesRGB565"] = true; //opaque images are uploaded with 16 bits per pixel
+	mBoolMap["TexturesRGBA4444"] = false; //so are images with transparency, at the cost of visible banding
 
 	mIntMap["DIMTIME"] = 30*1000;
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
 
 	mIntMap["GameListSortIndex"] = 0;
+	mIntMap["LoadThreads"] = 0; //0 = one per hardware thread
+	mIntMap["ScanThreads"] = 0; //0 = one per hardware thread, split between the systems loading at the same time
+	mIntMap["PlayedCollectionSize"] = 25; //games kept in "Recently Played" and "Most Played"
+	mIntMap["TextureLoadThreads"] = 2; //0 = one per hardware thread
+	mIntMap["TextureUploadTime"] = 4; //milliseconds per frame spent uploading decoded images
+	mIntMap["TextureCacheSize"] = 64; //MB of textures kept around for reuse
+	mIntMap["PrefetchDepth"] = 12; //most game images loaded ahead of the cursor, 0 = off
+	mIntMap["ThumbnailCacheSize"] = 256; //MB of scaled down images kept on disk, 0 = off
+	mIntMap["TextureAtlasMaxSize"] = 128; //images up to this many pixels wide and high share textures, 0 = off
 
 
 	mScraper = std::shared_ptr<Scraper>(new GamesDBScraper());
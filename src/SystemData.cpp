@@ -1,6 +1,7 @@
 #include "SystemData.h"
 #include "GameData.h"
 #include "XMLReader.h"
+#include "GamelistCache.h"
 #include <boost/filesystem.hpp>
 #include <fstream>
 #include <stdlib.h>
@@ -11,7 +12,12 @@
 #include "Log.h"
 #include "InputManager.h"
 #include <iostream>
+#include <thread>
+#include <atomic>
 #include "Settings.h"
+#include "DirectoryScanner.h"
+#include "LibraryWatcher.h"
+#include "PlayedGamesFolder.h"
 
 std::vector<SystemData*> SystemData::sSystemVector;
 
@@ -24,6 +30,55 @@ std::string SystemData::getEmulatorScreenshotDumpDir() { return mEmulatorScreens
 
 namespace
 {
+	//everything read from an es_systems.cfg <system> tag, used to construct the SystemData later
+	struct SystemConfig
+	{
+		std::string name;
+		std::string fullName;
+		std::string startPath;
+		std::vector<std::string> extensions;
+		std::string command;
+		std::string emulatorScreenshotDumpDir;
+		std::string screenshotDir;
+		PlatformIds::PlatformId platformId;
+	};
+
+	//number of threads used to load systemCount systems, as configured by the "LoadThreads" setting (0 = one per hardware thread)
+	unsigned int getLoadThreadCount(size_t systemCount)
+	{
+		int setting = Settings::getInstance()->getInt("LoadThreads");
+		unsigned int count = setting > 0 ? (unsigned int)setting : std::thread::hardware_concurrency();
+		if(count == 0)
+			count = 1;
+		if(count > systemCount)
+			count = (unsigned int)systemCount;
+		return count;
+	}
+
+	//systems being loaded at the same time right now, see loadConfig
+	unsigned int sConcurrentLoads = 1;
+
+	//number of threads one system's scan uses: the "ScanThreads" setting (0 = one per hardware thread) is shared by the
+	//systems that load at the same time, so parallel loads don't start a full pool each
+	unsigned int getScanThreadCount()
+	{
+		int setting = Settings::getInstance()->getInt("ScanThreads");
+		unsigned int count = setting > 0 ? (unsigned int)setting : std::thread::hardware_concurrency();
+		count /= sConcurrentLoads;
+		return count > 0 ? count : 1;
+	}
+
+	//true if directory (as a game keeps it, ending with a separator) is the path of folder - the root folder's path may
+	//end with one too
+	bool isDirectoryOf(const std::string& directory, const FolderData* folder)
+	{
+		const std::string& folderPath = folder->getPath();
+		if(!folderPath.empty() && folderPath[folderPath.length() - 1] == '/')
+			return directory == folderPath;
+
+		return directory.length() == folderPath.length() + 1 && directory.compare(0, folderPath.length(), folderPath) == 0;
+	}
+
 	//expand home symbol if the startpath contains ~
 	void expandTilde(std::string &path)
 	{
@@ -33,6 +88,32 @@ namespace
 			path.insert(0, getHomePath());
 		}
 	}
+
+	//fills folder with the games and subfolders of a scanned directory, same as the old recursive populateFolder did
+	void buildFolder(SystemData* system, FolderData* folder, const DirectoryScanner::Directory& dir)
+	{
+		for(auto it = dir.entries.begin(); it != dir.entries.end(); it++)
+		{
+			//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
+			//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+			if(it->isGame)
+			{
+				GameData* newGame = system->createGame(DirectoryScanner::joinPath(dir.path, it->name), MetaDataList(system->getGameMDD()));
+				folder->pushFileData(newGame);
+			}
+			else if(it->directory)
+			{
+				FolderData* newFolder = system->createFolder(it->directory->path, fs::path(it->name).stem().string());
+				buildFolder(system, newFolder, *it->directory);
+
+				//ignore folders that do not contain games
+				if(newFolder->getFileCount() == 0)
+					system->destroyFile(newFolder);
+				else
+					folder->pushFileData(newFolder);
+			}
+		}
+	}
 }
 
 SystemData::SystemData(const std::string& name, const std::string& fullName, const std::string& startPath, const std::vector<std::string>& extensions, 
@@ -51,16 +132,18 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, con
 	mSearchExtensions = extensions;
 	mLaunchCommand = command;
 	mPlatformId = platformId;
+	mGamesVersion = 0;
+	mSearchIndexBuilt = false;
 
-	mRootFolder = new FolderData(this, mStartPath, "Search Root");
+	mRootFolder = createFolder(mStartPath, "Search Root");
 
 	if(!Settings::getInstance()->getBool("PARSEGAMELISTONLY"))
 		populateFolder(mRootFolder);
 
-	if(!Settings::getInstance()->getBool("IGNOREGAMELIST"))
+	if(!Settings::getInstance()->getBool("IGNOREGAMELIST") && !loadGamelistCache(this))
 		parseGamelist(this);
 
-	mRootFolder->sort();
+        //folders are sorted when they're shown
         mRootFolder->reselect();
 }
 
@@ -70,7 +153,39 @@ SystemData::~SystemData()
 	if(!Settings::getInstance()->getBool("IGNOREGAMELIST")) {
 		updateGamelist(this);
 	}
-	delete mRootFolder;
+
+	//the whole tree goes at once, with the arenas
+	mRootFolder = NULL;
+	mGameIndex.clear();
+	mSearchIndex.clear();
+	mGameArena.clear();
+	mFolderArena.clear();
+}
+
+GameData* SystemData::createGame(const std::string& path, const MetaDataList& metadata)
+{
+	size_t separator = path.rfind('/') + 1; //0 if there is none
+	const std::string* directory = &(*mDirectories.insert(path.substr(0, separator)).first);
+	return mGameArena.create(directory, path.substr(separator), metadata);
+}
+
+FolderData* SystemData::createFolder(const std::string& path, const std::string& name)
+{
+	return mFolderArena.create(this, path, name);
+}
+
+void SystemData::destroyFile(FileData* file)
+{
+	if(file->isFolder())
+	{
+		FolderData* folder = (FolderData*)file;
+		for(unsigned int i = 0; i < folder->getFileCount(); i++)
+			destroyFile(folder->getFile(i));
+
+		mFolderArena.destroy(folder);
+	}else{
+		mGameArena.destroy((GameData*)file);
+	}
 }
 
 std::string strreplace(std::string& str, std::string replace, std::string with)
@@ -115,66 +230,158 @@ void SystemData::launchGame(Window* window, GameData* game)
 	//update number of times the game has been launched and the time
 	game->incTimesPlayed();
 	game->lastPlayedNow();
+	PlayedGamesFolder::gamePlayed(this, game);
 }
 
 void SystemData::populateFolder(FolderData* folder)
 {
-	std::string folderPath = folder->getPath();
-	if(!fs::is_directory(folderPath))
-	{
-		LOG(LogWarning) << "Error - folder with path \"" << folderPath << "\" is not a directory!";
+	//listings of directories that didn't change since the last start are reused, unless a full rescan was requested
+	ScanCache cache;
+	if(!Settings::getInstance()->getBool("ForceRescan"))
+		cache.load(getScanCachePath());
+
+	DirectoryScanner scanner(mSearchExtensions, getScanThreadCount(), &cache);
+
+	std::unique_ptr<DirectoryScanner::Directory> dir = scanner.scan(folder->getPath());
+	if(!dir)
 		return;
+
+	//remember every directory (even empty ones) so the LibraryWatcher knows what to watch
+	mScannedDirectories.clear();
+	dir->collectPaths(mScannedDirectories);
+
+	LOG(LogInfo) << "Scanned " << getName() << ": " << cache.getHits() << " directories unchanged, " << cache.getMisses() << " read";
+	cache.save(getScanCachePath());
+
+	buildFolder(this, folder, *dir);
+}
+
+bool SystemData::getFolderChain(const std::string& directory, std::vector<FolderData*>& chain) const
+{
+	chain.assign(1, mRootFolder);
+
+	std::string rootPath = mRootFolder->getPath();
+	if(rootPath.empty() || rootPath[rootPath.length() - 1] != '/')
+		rootPath += "/";
+
+	std::string parentPath = directory;
+	if(parentPath + "/" == rootPath)
+		parentPath = mRootFolder->getPath(); //start path with a trailing slash
+	else if(parentPath.compare(0, rootPath.length(), rootPath) != 0)
+		return false;
+
+	while(chain.back()->getPath() != parentPath)
+	{
+		const std::string& folderPath = chain.back()->getPath();
+		size_t end = parentPath.find('/', folderPath.length() + 1);
+		std::string nextPath = parentPath.substr(0, end);
+
+		FolderData* next = chain.back()->getSubfolder(nextPath);
+		if(next == NULL)
+			return false;
+		chain.push_back(next);
 	}
 
-	//make sure that this isn't a symlink to a thing we already have
-	if(fs::is_symlink(folderPath))
+	return true;
+}
+
+FolderData* SystemData::applyFileChange(const std::string& path)
+{
+	std::string rootPath = mRootFolder->getPath();
+	if(rootPath.empty() || rootPath[rootPath.length() - 1] != '/')
+		rootPath += "/";
+	if(path.compare(0, rootPath.length(), rootPath) != 0)
+		return NULL;
+
+	fs::path filePath(path);
+	std::string parentPath = filePath.parent_path().generic_string();
+	if(parentPath + "/" == rootPath)
+		parentPath = mRootFolder->getPath(); //start path with a trailing slash
+
+	//folders without games were never added (see populateFolder), the parent directory may not be in the tree
+	std::vector<FolderData*> chain;
+	bool parentFound = getFolderChain(parentPath, chain);
+
+	FileData* existing = NULL;
+	if(parentFound)
 	{
-		//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
-		if(folderPath.find(fs::canonical(folderPath).string()) == 0)
+		existing = chain.back()->getSubfolder(path);
+		if(!existing)
 		{
-			LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << folderPath << "\"";
-			return;
+			//every game is in the folder of its directory, no need to look through the folder's files
+			GameData* game = getGameByPath(path);
+			if(game && isDirectoryOf(game->getDirectory(), chain.back()))
+				existing = game;
 		}
 	}
 
-	fs::path filePath;
-	std::string extension;
-	bool isGame;
-	for(fs::directory_iterator end, dir(folderPath); dir != end; ++dir)
-	{
-		filePath = (*dir).path();
+	//check what is on disk now, the same way populateFolder would
+	boost::system::error_code ec;
+	bool isDirectory = fs::is_directory(path, ec);
+	bool exists = isDirectory || fs::exists(path, ec);
+	bool isGame = exists && !filePath.stem().string().empty() &&
+		std::find(mSearchExtensions.begin(), mSearchExtensions.end(), filePath.extension().string()) != mSearchExtensions.end();
 
-		if(filePath.stem().string().empty())
-			continue;
+	FolderData* changed = NULL;
+	if(existing)
+	{
+		//still the same kind of thing, nothing to do
+		if(existing->isFolder() ? (isDirectory && !isGame) : isGame)
+			return NULL;
 
-		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
-		//we first get the extension of the file itself:
-		extension = filePath.extension().string();
-		
-		//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
-		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+		chain.back()->removeFileRecursive(existing);
+		changed = chain.back();
 
-		isGame = false;
-		if(std::find(mSearchExtensions.begin(), mSearchExtensions.end(), extension) != mSearchExtensions.end())
+		//remove folders that don't contain games anymore, but keep the root
+		while(chain.size() > 1 && chain.back()->getFileCount() == 0)
 		{
-			GameData* newGame = new GameData(filePath.generic_string(), MetaDataList(getGameMDD()));
-			folder->pushFileData(newGame);
-			isGame = true;
+			FolderData* empty = chain.back();
+			chain.pop_back();
+			chain.back()->removeFileRecursive(empty);
+			changed = chain.back();
 		}
+		parentFound = (chain.back()->getPath() == parentPath);
+	}
 
-		//add directories that also do not match an extension as folders
-		if(!isGame && fs::is_directory(filePath))
+	FileData* newFile = NULL;
+	if(isGame)
+	{
+		newFile = createGame(filePath.generic_string(), MetaDataList(getGameMDD()));
+	}else if(isDirectory)
+	{
+		//a single directory, usually small - not worth a pool of threads
+		DirectoryScanner scanner(mSearchExtensions, 1);
+		std::unique_ptr<DirectoryScanner::Directory> dir = scanner.scan(path);
+		if(dir)
 		{
-			FolderData* newFolder = new FolderData(this, filePath.generic_string(), filePath.stem().string());
-			populateFolder(newFolder);
+			FolderData* newFolder = createFolder(path, filePath.stem().string());
+			buildFolder(this, newFolder, *dir);
 
 			//ignore folders that do not contain games
 			if(newFolder->getFileCount() == 0)
-				delete newFolder;
+				destroyFile(newFolder);
 			else
-				folder->pushFileData(newFolder);
+				newFile = newFolder;
 		}
 	}
+
+	if(!newFile)
+		return changed;
+
+	//create the folders between the deepest one we found and the parent directory
+	FolderData* folder = chain.back();
+	while(folder->getPath() != parentPath)
+	{
+		size_t end = parentPath.find('/', folder->getPath().length() + 1);
+		std::string nextPath = parentPath.substr(0, end);
+
+		FolderData* newFolder = createFolder(nextPath, fs::path(nextPath).stem().string());
+		folder->pushFileData(newFolder);
+		folder = newFolder;
+	}
+
+	folder->pushFileData(newFile);
+	return folder;
 }
 
 std::string SystemData::getName()
@@ -220,53 +427,94 @@ bool SystemData::loadConfig(const std::string& path, bool writeExample)
 	//actually read the file
 	pugi::xml_node systemList = doc.child("systemList");
 
+	std::vector<SystemConfig> configs;
 	for(pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{
-		std::string name, fullname, path, cmd, emulatorScreenshotDumpDir, screenshotDir;
-		PlatformIds::PlatformId platformId = PlatformIds::PLATFORM_UNKNOWN;
+		SystemConfig config;
+		std::string path;
 
-		name = system.child("name").text().get();
-		fullname = system.child("fullname").text().get();
+		config.name = system.child("name").text().get();
+		config.fullName = system.child("fullname").text().get();
 		path = system.child("path").text().get();
 
 		//convert extensions list from a string into a vector of strings
 		const pugi::char_t* extStr = system.child("extension").text().get();
-		std::vector<std::string> extensions;
 		std::vector<char> buff(strlen(extStr) + 1);
 		strcpy(buff.data(), extStr);
 		char* ext = strtok(buff.data(), " ");
 		while(ext != NULL)
 		{
-			extensions.push_back(ext);
+			config.extensions.push_back(ext);
 			ext = strtok(NULL, " ");
 		}
 
-		cmd = system.child("command").text().get();
-                emulatorScreenshotDumpDir = system.child("emulatorScreenshotDumpDir").text().get();
-                screenshotDir = system.child("screenshotDir").text().get();
-		platformId = (PlatformIds::PlatformId)system.child("platformid").text().as_uint(PlatformIds::PLATFORM_UNKNOWN);
+		config.command = system.child("command").text().get();
+                config.emulatorScreenshotDumpDir = system.child("emulatorScreenshotDumpDir").text().get();
+                config.screenshotDir = system.child("screenshotDir").text().get();
+		config.platformId = (PlatformIds::PlatformId)system.child("platformid").text().as_uint(PlatformIds::PLATFORM_UNKNOWN);
 
 		//validate
-		if(name.empty() || path.empty() || extensions.empty() || cmd.empty())
+		if(config.name.empty() || path.empty() || config.extensions.empty() || config.command.empty())
 		{
-			LOG(LogError) << "System \"" << name << "\" is missing name, path, extension, or command!";
+			LOG(LogError) << "System \"" << config.name << "\" is missing name, path, extension, or command!";
 			continue;
 		}
 
 		//convert path to generic directory seperators
 		boost::filesystem::path genericPath(path);
-		path = genericPath.generic_string();
+		config.startPath = genericPath.generic_string();
 
-		SystemData* newSys = new SystemData(name, fullname, path, extensions, cmd, emulatorScreenshotDumpDir, screenshotDir, platformId);
+		configs.push_back(config);
+	}
+
+	//scanning the ROM folders and parsing the gamelists is mostly I/O bound, so the systems are loaded on a pool of worker threads.
+	//every worker grabs the next unloaded system until none are left, results are stored by config index to keep the config order.
+	std::vector<SystemData*> loaded(configs.size(), NULL);
+	std::atomic<unsigned int> nextConfig(0);
+	auto loadWorker = [&configs, &loaded, &nextConfig]
+	{
+		unsigned int i;
+		while((i = nextConfig++) < configs.size())
+		{
+			const SystemConfig& config = configs.at(i);
+			boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+			loaded.at(i) = new SystemData(config.name, config.fullName, config.startPath, config.extensions, config.command, 
+				config.emulatorScreenshotDumpDir, config.screenshotDir, config.platformId);
+
+			boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+			LOG(LogInfo) << "Loaded system \"" << config.name << "\" (" << loaded.at(i)->getGameCount() << " games) in " << elapsed.total_milliseconds() << "ms";
+		}
+	};
+
+	unsigned int threadCount = getLoadThreadCount(configs.size());
+	LOG(LogInfo) << "Loading " << configs.size() << " systems using " << threadCount << " thread(s)...";
+
+	//the calling thread works too, so we only need threadCount - 1 helpers
+	sConcurrentLoads = threadCount;
+	std::vector<std::thread> workers;
+	for(unsigned int i = 1; i < threadCount; i++)
+		workers.push_back(std::thread(loadWorker));
+	loadWorker();
+	for(auto it = workers.begin(); it != workers.end(); it++)
+		it->join();
+	sConcurrentLoads = 1;
+
+	for(unsigned int i = 0; i < loaded.size(); i++)
+	{
+		SystemData* newSys = loaded.at(i);
 		if(newSys->getRootFolder()->getFileCount() == 0)
 		{
-			LOG(LogWarning) << "System \"" << name << "\" has no games! Ignoring it.";
+			LOG(LogWarning) << "System \"" << newSys->getName() << "\" has no games! Ignoring it.";
 			delete newSys;
 		}else{
 			sSystemVector.push_back(newSys);
 		}
 	}
 
+	PlayedGamesFolder::restore(sSystemVector);
+	LibraryWatcher::getInstance()->start(sSystemVector);
+
 	return true;
 }
 
@@ -314,6 +562,10 @@ void SystemData::writeExampleConfig(const std::string& path)
 
 void SystemData::deleteSystems()
 {
+	//the watcher refers to the systems
+	LibraryWatcher::getInstance()->stop();
+	PlayedGamesFolder::clearAll();
+
 	for(unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		delete sSystemVector.at(i);
@@ -352,12 +604,22 @@ std::string SystemData::getGamelistPath()
 	return filePath;
 }
 
+const std::vector<std::string>& SystemData::getScannedDirectories() const
+{
+	return mScannedDirectories;
+}
+
+std::string SystemData::getScanCachePath()
+{
+	return getHomePath() + "/.emulationstation/" + getName() + "/scancache.bin";
+}
+
 bool SystemData::hasGamelist()
 {
 	return (fs::exists(getGamelistPath()));
 }
 
-std::vector<MetaDataDecl> SystemData::getGameMDD()
+const std::vector<MetaDataDecl>& SystemData::getGameMDD()
 {
 	return MetaDataList::getDefaultGameMDD();
 }
@@ -367,7 +629,82 @@ PlatformIds::PlatformId SystemData::getPlatformId()
 	return mPlatformId;
 }
 
+size_t SystemData::GamePathHash::operator()(const GamePath& path) const
+{
+	return std::hash<const std::string*>()(path.directory) * 31 + std::hash<std::string>()(*path.fileName);
+}
+
+bool SystemData::GamePathEqual::operator()(const GamePath& a, const GamePath& b) const
+{
+	return a.directory == b.directory && *a.fileName == *b.fileName;
+}
+
+SystemData::GamePath SystemData::getGamePath(GameData* game)
+{
+	GamePath path = { &game->getDirectory(), &game->getFileName() };
+	return path;
+}
+
+GameData* SystemData::getGameByPath(const std::string& path) const
+{
+	//split the way createGame does - a directory we don't have can't have any of our games
+	size_t separator = path.rfind('/') + 1;
+	auto directory = mDirectories.find(path.substr(0, separator));
+	if(directory == mDirectories.end())
+		return NULL;
+
+	const std::string fileName = path.substr(separator);
+	GamePath key = { &(*directory), &fileName };
+	auto it = mGameIndex.find(key);
+	return it == mGameIndex.end() ? NULL : it->second;
+}
+
+void SystemData::indexGame(GameData* game)
+{
+	mGameIndex[getGamePath(game)] = game;
+	mGamesVersion++;
+
+	if(mSearchIndexBuilt)
+		mSearchIndex.add(game);
+}
+
+void SystemData::unindexGame(GameData* game)
+{
+	auto it = mGameIndex.find(getGamePath(game));
+	if(it != mGameIndex.end() && it->second == game)
+		mGameIndex.erase(it);
+	mGamesVersion++;
+
+	if(mSearchIndexBuilt)
+		mSearchIndex.remove(game);
+
+	PlayedGamesFolder::gameRemoved(game);
+}
+
+unsigned int SystemData::getGamesVersion() const
+{
+	return mGamesVersion;
+}
+
+const GameSearchIndex& SystemData::getSearchIndex()
+{
+	if(!mSearchIndexBuilt)
+	{
+		GameSearchIndex& index = mSearchIndex;
+		mRootFolder->visitGames([&index](GameData* game) { index.add(game); });
+		mSearchIndexBuilt = true;
+	}
+
+	return mSearchIndex;
+}
+
+void SystemData::updateSearchIndex(GameData* game)
+{
+	if(mSearchIndexBuilt)
+		mSearchIndex.update(game);
+}
+
 unsigned int SystemData::getGameCount()
 {
-	return mRootFolder->getFilesRecursive(true).size();
+	return mRootFolder->getGameCount();
 }
@@ -3,13 +3,16 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include "FolderData.h"
+#include "GameData.h"
+#include "ObjectArena.h"
+#include "GameSearchIndex.h"
 #include "Window.h"
 #include "MetaData.h"
 #include "PlatformId.h"
 
-class GameData;
-
 class SystemData
 {
 public:
@@ -23,18 +26,45 @@ public:
 	std::string getFullName();
 	std::string getStartPath();
 	std::string getGamelistPath();
+	std::string getScanCachePath();
+	const std::vector<std::string>& getScannedDirectories() const; //every directory populateFolder read, including ones without games
         std::string getScreenshotDir();
         std::string getEmulatorScreenshotDumpDir();
 	std::vector<std::string> getExtensions();
 	PlatformIds::PlatformId getPlatformId();
 
 	bool hasGamelist();
-	std::vector<MetaDataDecl> getGameMDD();
+	const std::vector<MetaDataDecl>& getGameMDD();
 
 	unsigned int getGameCount();
 
+	//Finds a game in this system by its (generic) path, or NULL. The index is kept up to date by FolderData.
+	GameData* getGameByPath(const std::string& path) const;
+	void indexGame(GameData* game);
+	void unindexGame(GameData* game);
+	unsigned int getGamesVersion() const; //changes whenever a game is added to or removed from this system
+
+	//The index type-to-search looks up this system's games in. It is built by the first call and kept up to date after
+	//that - games added and removed are handled by indexGame and unindexGame, call updateSearchIndex after renaming one.
+	const GameSearchIndex& getSearchIndex();
+	void updateSearchIndex(GameData* game);
+
+	//Every file of this system's tree is created (and destroyed) here, they live in the system's arenas.
+	//Games share one copy of their directory path. Destroying a folder destroys everything in it.
+	GameData* createGame(const std::string& path, const MetaDataList& metadata);
+	FolderData* createFolder(const std::string& path, const std::string& name);
+	void destroyFile(FileData* file);
+
 	void launchGame(Window* window, GameData* game);
 
+	//Fills chain with the folders from the root down to directory, as far as they are in the tree.
+	//Returns true if the folder for directory itself is in the tree (it is chain.back() then).
+	bool getFolderChain(const std::string& directory, std::vector<FolderData*>& chain) const;
+
+	//Brings the tree up to date with whatever is at path on disk now (something was added, removed or renamed there).
+	//Returns the folder whose contents changed, or NULL if nothing changed. Folders may be deleted by this!
+	FolderData* applyFileChange(const std::string& path);
+
 	static void deleteSystems();
 	static bool loadConfig(const std::string& path, bool writeExampleIfNonexistant = true); //Load the system config file at getConfigPath(). Returns true if no errors were encountered. An example can be written if the file doesn't exist.
 	static void writeExampleConfig(const std::string& path);
@@ -52,8 +82,35 @@ private:
 	PlatformIds::PlatformId mPlatformId;
 
 	void populateFolder(FolderData* folder);
+	std::vector<std::string> mScannedDirectories;
+
+	ObjectArena<GameData> mGameArena;
+	ObjectArena<FolderData> mFolderArena;
+	std::unordered_set<std::string> mDirectories; //the directory part of every game path, games point into this
+
+	//a game's path as the two parts it keeps it in, neither is copied - the directory is one of mDirectories
+	struct GamePath
+	{
+		const std::string* directory;
+		const std::string* fileName;
+	};
+	struct GamePathHash
+	{
+		size_t operator()(const GamePath& path) const;
+	};
+	struct GamePathEqual
+	{
+		bool operator()(const GamePath& a, const GamePath& b) const;
+	};
+	static GamePath getGamePath(GameData* game);
 
 	FolderData* mRootFolder;
+	std::unordered_map<GamePath, GameData*, GamePathHash, GamePathEqual> mGameIndex; //path -> game, for every game in mRootFolder
+
+	unsigned int mGamesVersion;
+
+	GameSearchIndex mSearchIndex;
+	bool mSearchIndexBuilt;
 };
 
 #endif
@@ -5,6 +5,9 @@
 #include "VolumeControl.h"
 #include "Log.h"
 #include "Settings.h"
+#include "resources/TextureLoader.h"
+#include "resources/TextureCache.h"
+#include "resources/TextureAtlas.h"
 #include <iomanip>
 
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10), 
@@ -74,6 +77,14 @@ bool Window::init(unsigned int width, unsigned int height)
 void Window::deinit()
 {
 	mInputManager->deinit();
+	TextureLoader::getInstance()->clear();
+
+	TextureCache::Stats stats = TextureCache::getInstance()->getStats();
+	LOG(LogInfo) << "Texture cache: " << stats.textures << " texture(s), " << (stats.residentBytes / 1024) << " KB resident ("
+		<< (stats.savedBytes / 1024) << " KB saved by 16 bit formats), "
+		<< stats.hits << " hit(s), " << stats.misses << " miss(es), " << stats.evictions << " eviction(s)";
+	TextureCache::getInstance()->purge();
+
 	ResourceManager::getInstance()->unloadAll();
 	Renderer::deinit();
 }
@@ -112,6 +123,12 @@ void Window::update(int deltaTime)
 			std::stringstream ss;
 			ss << std::fixed << std::setprecision(1) << (1000.0f * (float)mFrameCountElapsed / (float)mFrameTimeElapsed) << "fps, ";
 			ss << std::fixed << std::setprecision(2) << ((float)mFrameTimeElapsed / (float)mFrameCountElapsed) << "ms";
+
+			TextureCache::Stats stats = TextureCache::getInstance()->getStats();
+			ss << "\ntextures: " << stats.textures << ", " << std::setprecision(1) << (stats.residentBytes / (1024.0f * 1024.0f)) << "MB (";
+			ss << (stats.savedBytes / (1024.0f * 1024.0f)) << "MB saved), ";
+			ss << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions, ";
+			ss << TextureAtlas::getInstance()->getPageCount() << " atlas pages";
 			mFrameDataString = ss.str();
 		}
 
@@ -119,6 +136,8 @@ void Window::update(int deltaTime)
 		mFrameCountElapsed = 0;
 	}
 
+	TextureLoader::getInstance()->uploadPending();
+
 	if(peekGui())
 		peekGui()->update(deltaTime);
 }
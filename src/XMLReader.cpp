@@ -5,27 +5,32 @@
 #include <boost/filesystem.hpp>
 #include "Log.h"
 #include "Settings.h"
+#include "DirectoryScanner.h"
+#include "GamelistWriter.h"
+#include "GamelistCache.h"
+#include <unordered_map>
 
-//this is obviously an incredibly inefficient way to go about searching
-//but I don't think it'll matter too much with the size of most collections
-GameData* searchFolderByPath(FolderData* folder, std::string const& path)
+std::string resolveGamePath(const std::string& nodePath, const std::string& xmlpath)
 {
-	for(unsigned int i = 0; i < folder->getFileCount(); i++)
+	//convert path to generic directory seperators
+	boost::filesystem::path gamePath(nodePath);
+	std::string path = gamePath.generic_string();
+
+	//expand '.'
+	if(path[0] == '.')
 	{
-		FileData* file = folder->getFile(i);
+		path.erase(0, 1);
+		path.insert(0, boost::filesystem::path(xmlpath).parent_path().generic_string());
+	}
 
-		if(file->isFolder())
-		{
-			GameData* result = searchFolderByPath((FolderData*)file, path);
-			if(result)
-				return (GameData*)result;
-		}else{
-			if(file->getPath() == path)
-				return (GameData*)file;
-		}
+	//expand '~'
+	if(path[0] == '~')
+	{
+		path.erase(0, 1);
+		path.insert(0, getHomePath());
 	}
 
-	return NULL;
+	return path;
 }
 
 GameData* createGameFromPath(std::string gameAbsPath, SystemData* system)
@@ -61,23 +66,14 @@ GameData* createGameFromPath(std::string gameAbsPath, SystemData* system)
 		std::string checkName = gamePath.substr(separator + 1, nextSeparator - separator - 1);
 		separator = nextSeparator;
 
-		//see if the folder already exists
-		bool foundFolder = false;
-		for(unsigned int i = 0; i < folder->getFileCount(); i++)
+		//see if the folder already exists, create it if it doesn't
+		std::string checkPath = DirectoryScanner::joinPath(folder->getPath(), checkName);
+		FolderData* checkFolder = folder->getSubfolder(checkPath);
+		if(checkFolder)
 		{
-			FileData* checkFolder = folder->getFile(i);
-			if(checkFolder->isFolder() && checkFolder->getName() == checkName)
-			{
-				folder = (FolderData*)checkFolder;
-				foundFolder = true;
-				break;
-			}
-		}
-
-		//the folder didn't already exist, so create it
-		if(!foundFolder)
-		{
-			FolderData* newFolder = new FolderData(system, folder->getPath() + "/" + checkName, checkName);
+			folder = checkFolder;
+		}else{
+			FolderData* newFolder = system->createFolder(checkPath, checkName);
 			folder->pushFileData(newFolder);
 			folder = newFolder;
 		}
@@ -91,11 +87,50 @@ GameData* createGameFromPath(std::string gameAbsPath, SystemData* system)
 		loops++;
 	}
 
-	GameData* game = new GameData(gameAbsPath, MetaDataList(system->getGameMDD()));
+	GameData* game = system->createGame(gameAbsPath, MetaDataList(system->getGameMDD()));
 	folder->pushFileData(game);
 	return game;
 }
 
+GameData* getGamelistGame(SystemData* system, const std::string& path)
+{
+	//games the directory scan found are known to exist, only entries for anything else need to hit the disk
+	GameData* game = system->getGameByPath(path);
+	if(game == NULL)
+	{
+		if(!boost::filesystem::exists(path))
+		{
+			LOG(LogWarning) << "Game at \"" << path << "\" does not exist!";
+			return NULL;
+		}
+
+		game = createGameFromPath(path, system);
+	}
+	return game;
+}
+
+void applyGamelistEntry(SystemData* system, const std::string& path, const MetaDataList& metadata)
+{
+	GameData* game = getGamelistGame(system, path);
+	if(game == NULL)
+		return;
+
+	//load the metadata
+	*(game->metadata()) = metadata;
+	gamelistEntryLoaded(system, game);
+}
+
+void gamelistEntryLoaded(SystemData* system, GameData* game)
+{
+	//make sure name gets set if one didn't exist (the default name isn't saved, so this is no change)
+	if(game->metadata()->get("name").empty())
+	{
+		game->metadata()->set("name", game->getBaseName());
+		game->metadata()->setDirty(false);
+	}
+	system->updateSearchIndex(game);
+}
+
 void parseGamelist(SystemData* system)
 {
 	std::string xmlpath = system->getGamelistPath();
@@ -121,6 +156,8 @@ void parseGamelist(SystemData* system)
 		return;
 	}
 
+	//next start can skip all of this
+	GamelistCacheWriter cache;
 	for(pugi::xml_node gameNode = root.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
 	{
 		pugi::xml_node pathNode = gameNode.child("path");
@@ -130,74 +167,76 @@ void parseGamelist(SystemData* system)
 			continue;
 		}
 
-		//convert path to generic directory seperators
-		boost::filesystem::path gamePath(pathNode.text().get());
-		std::string path = gamePath.generic_string();
-
-		//expand '.'
-		if(path[0] == '.')
-		{
-			path.erase(0, 1);
-			path.insert(0, boost::filesystem::path(xmlpath).parent_path().generic_string());
-		}
-
-		//expand '~'
-		if(path[0] == '~')
-		{
-			path.erase(0, 1);
-			path.insert(0, getHomePath());
-		}
-
-		if(boost::filesystem::exists(path))
-		{
-			GameData* game = searchFolderByPath(system->getRootFolder(), path);
-
-			if(game == NULL)
-				game = createGameFromPath(path, system);
-
-			//load the metadata
-			*(game->metadata()) = MetaDataList::createFromXML(system->getGameMDD(), gameNode);
-
-			//make sure name gets set if one didn't exist
-			if(game->metadata()->get("name").empty())
-				game->metadata()->set("name", game->getBaseName());
-		}else{
-			LOG(LogWarning) << "Game at \"" << path << "\" does not exist!";
-		}
+		std::string path = resolveGamePath(pathNode.text().get(), xmlpath);
+		MetaDataList metadata = MetaDataList::createFromXML(system->getGameMDD(), gameNode);
+		cache.add(path, metadata);
+		applyGamelistEntry(system, path, metadata);
 	}
+
+	cache.write(system->getName(), xmlpath);
 }
 
-void addGameDataNode(pugi::xml_node& parent, const GameData* game, SystemData* system)
+//writes the game into a new <game> node, inserted before "before" (or appended if that's empty)
+void addGameDataNode(pugi::xml_node& parent, const GameSnapshot& game, const std::vector<MetaDataDecl>& mdd, pugi::xml_node before = pugi::xml_node())
 {
 	//create game and add to parent node
-	pugi::xml_node newGame = parent.append_child("game");
+	pugi::xml_node newGame = before ? parent.insert_child_before("game", before) : parent.append_child("game");
 
 	//write metadata
-	const_cast<GameData*>(game)->metadata()->appendToXML(newGame, system->getGameMDD());
+	game.metadata.appendToXML(newGame, mdd);
 	
 	if(newGame.children().begin() == newGame.child("name") //first element is name
 		&& ++newGame.children().begin() == newGame.children().end() //theres only one element
-		&& newGame.child("name").text().get() == game->getBaseName()) //the name is the default
+		&& newGame.child("name").text().get() == game.baseName) //the name is the default
 	{
 		//if the only info is the default name, don't bother with this node
 		parent.remove_child(newGame);
 	}else{
 		//there's something useful in there so we'll keep the node, add the path
-		newGame.prepend_child("path").text().set(game->getPath().c_str());
+		newGame.prepend_child("path").text().set(game.path.c_str());
 	}
 }
 
-void updateGamelist(SystemData* system)
+bool takeGamelistChanges(SystemData* system, GamelistSnapshot& snapshot)
 {
-	//We do this by reading the XML again, adding changes and then writing it back,
-	//because there might be information missing in our systemdata which would then miss in the new XML.
-	//We have the complete information for every game though, so we can simply remove a game
-	//we already have in the system from the XML, and then add it back from its GameData information...
-
 	if(Settings::getInstance()->getBool("DisableGamelistWrites") || Settings::getInstance()->getBool("IGNOREGAMELIST"))
-		return;
+		return false;
 
-	std::string xmlpath = system->getGamelistPath();
+	FolderData * rootFolder = system->getRootFolder();
+	if (rootFolder == nullptr)
+	{
+		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
+		return false;
+	}
+
+	snapshot.systemName = system->getName();
+	snapshot.xmlPath = system->getGamelistPath();
+	snapshot.mdd = system->getGameMDD();
+
+	//only games whose metadata changed since loading are written. if there is no file yet, everything is written
+	bool fileExists = boost::filesystem::exists(snapshot.xmlPath);
+
+	rootFolder->visitGames([&snapshot, fileExists](GameData* game) {
+		if(fileExists && !game->metadata()->isDirty())
+			return;
+
+		GameSnapshot gameSnapshot = { game->getPath(), game->getBaseName(), *game->metadata() };
+		snapshot.games.erase(gameSnapshot.path);
+		snapshot.games.insert(std::make_pair(gameSnapshot.path, gameSnapshot));
+
+		//the snapshot owns the change now
+		game->metadata()->setDirty(false);
+	});
+
+	return !snapshot.games.empty();
+}
+
+bool writeGamelist(const GamelistSnapshot& snapshot)
+{
+	//We do this by reading the XML again, adding changes and then writing it back,
+	//because there might be information missing in our systemdata which would then miss in the new XML.
+	//Every game in the snapshot replaces its old node in place.
+	const std::string& xmlpath = snapshot.xmlPath;
 
 	pugi::xml_document doc;
 
@@ -210,7 +249,7 @@ void updateGamelist(SystemData* system)
 		if(!result)
 		{
 			LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-			return;
+			return false;
 		}
 	}else{
 		//set up an empty gamelist to append to
@@ -226,57 +265,60 @@ void updateGamelist(SystemData* system)
 	if(!root)
 	{
 		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
-		return;
+		return false;
 	}
 
-	//now we have all the information from the XML. now iterate through all our games and add information from there
-	FolderData * rootFolder = system->getRootFolder();
-	if (rootFolder != nullptr)
+	//index the existing nodes by path once, so finding a game's node doesn't mean walking the whole document
+	std::unordered_map<std::string, pugi::xml_node> nodes;
+	for(pugi::xml_node gameNode = root.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
 	{
-		//get only files, no folders
-		std::vector<FileData*> files = rootFolder->getFilesRecursive(true);
-		//iterate through all files, checking if they're already in the XML
-		std::vector<FileData*>::const_iterator fit = files.cbegin();
-		while(fit != files.cend())
+		pugi::xml_node pathNode = gameNode.child("path");
+		if(!pathNode)
 		{
-			//try to cast to gamedata
-			const GameData * game = dynamic_cast<const GameData*>(*fit);
-			if (game != nullptr)
-			{
-				//worked. check if this games' path can be found somewhere in the XML
-				for(pugi::xml_node gameNode = root.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
-				{
-					//get path from game node
-					pugi::xml_node pathNode = gameNode.child("path");
-					if(!pathNode)
-					{
-						LOG(LogError) << "<game> node contains no <path> child!";
-						continue;
-					}
-
-					//check paths. use the same directory separators
-					boost::filesystem::path nodePath(pathNode.text().get());
-					boost::filesystem::path gamePath(game->getPath());
-					if (nodePath.generic_string() == gamePath.generic_string())
-					{
-						//found the game. remove it. it will be added again later with updated values
-						root.remove_child(gameNode);
-						//break node search loop
-						break;
-					}
-				}
-
-				//either the game content was removed, because it needs to be updated,
-				//or didn't exist in the first place, so just add it
-				addGameDataNode(root, game, system);
-			}
-			++fit;
+			LOG(LogError) << "<game> node contains no <path> child!";
+			continue;
 		}
-		//now write the file
-		if (!doc.save_file(xmlpath.c_str())) {
-			LOG(LogError) << "Error saving gamelist.xml file \"" << xmlpath << "\"!";
+
+		nodes.insert(std::make_pair(resolveGamePath(pathNode.text().get(), xmlpath), gameNode));
+	}
+
+	for(auto it = snapshot.games.cbegin(); it != snapshot.games.cend(); ++it)
+	{
+		//replace the old node (keeping its position), or add a new one if the game wasn't in the XML before
+		auto node = nodes.find(it->first);
+		if(node != nodes.end())
+		{
+			addGameDataNode(root, it->second, snapshot.mdd, node->second);
+			root.remove_child(node->second);
+			nodes.erase(node);
+		}else{
+			addGameDataNode(root, it->second, snapshot.mdd);
 		}
-	}else{
-		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
 	}
+
+	//now write the file, through a temporary file so a crash or a full disk can't leave a truncated gamelist behind
+	std::string tempPath = xmlpath + ".tmp";
+	if (!doc.save_file(tempPath.c_str())) {
+		LOG(LogError) << "Error saving gamelist.xml file \"" << tempPath << "\"!";
+		return false;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::rename(tempPath, xmlpath, ec);
+	if(ec)
+	{
+		LOG(LogError) << "Error replacing gamelist.xml file \"" << xmlpath << "\"! " << ec.message();
+		boost::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	writeGamelistCache(snapshot.systemName, xmlpath, root, snapshot.mdd);
+	return true;
+}
+
+void updateGamelist(SystemData* system)
+{
+	//goes through the writer, so an older write that is still queued can't overwrite this one later
+	GamelistWriter::getInstance()->queue(system);
+	GamelistWriter::getInstance()->flush();
 }
@@ -2,12 +2,52 @@
 #define _XMLREADER_H_
 
 #include <string>
+#include <vector>
+#include <map>
+#include "MetaData.h"
 class SystemData;
+class GameData;
+
+//A copy of a game's metadata, so it can be written to the gamelist on another thread.
+struct GameSnapshot
+{
+	std::string path;
+	std::string baseName;
+	MetaDataList metadata;
+};
+
+//Everything needed to write the changes of one system's gamelist.xml.
+struct GamelistSnapshot
+{
+	std::string systemName;
+	std::string xmlPath;
+	std::vector<MetaDataDecl> mdd;
+	std::map<std::string, GameSnapshot> games; //path -> game
+};
 
 //Loads gamelist.xml data into a SystemData.
 void parseGamelist(SystemData* system);
 
-//Writes changes to SystemData back to a previously loaded gamelist.xml.
+//Turns the <path> of a gamelist entry into the generic absolute path we use for GameData.
+std::string resolveGamePath(const std::string& nodePath, const std::string& xmlpath);
+
+//Gives the game at path (creating it if it wasn't scanned, but exists) the metadata of its gamelist entry.
+void applyGamelistEntry(SystemData* system, const std::string& path, const MetaDataList& metadata);
+
+//The two halves of applyGamelistEntry, for loading the metadata some other way: getGamelistGame returns the game at
+//path (creating it if it wasn't scanned, but exists) or NULL, gamelistEntryLoaded has to be called once its metadata
+//is set.
+GameData* getGamelistGame(SystemData* system, const std::string& path);
+void gamelistEntryLoaded(SystemData* system, GameData* game);
+
+//Copies the games of a system that changed since the last write into snapshot (replacing games that are already in it) and marks them clean.
+//Returns false if there is nothing to write. Main thread only.
+bool takeGamelistChanges(SystemData* system, GamelistSnapshot& snapshot);
+
+//Merges snapshot into its gamelist.xml and writes it atomically. Can be called from any thread, returns false on errors.
+bool writeGamelist(const GamelistSnapshot& snapshot);
+
+//Writes changes to SystemData back to a previously loaded gamelist.xml, right now.
 void updateGamelist(SystemData* system);
 
 #endif
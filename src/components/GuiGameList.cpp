@@ -7,8 +7,14 @@
 #include "../Log.h"
 #include "../Settings.h"
 
+#include "../LibraryWatcher.h"
 #include "GuiMetaDataEd.h"
 #include "GuiScraperStart.h"
+#include "GuiSearch.h"
+#include "../AllGamesFolder.h"
+#include "../PlayedGamesFolder.h"
+#include "../resources/TextureLoader.h"
+#include "../resources/ThumbnailCache.h"
 
 std::vector<FolderData::SortState> GuiGameList::sortStates;
 
@@ -19,6 +25,13 @@ Eigen::Vector3f GuiGameList::getImagePos()
 
 namespace {
 
+        // list entries prefetched ahead of the cursor while it stands still...
+        const int PREFETCH_MIN_DEPTH = 2;
+        // ...plus the ones it passes in this many seconds at its current speed
+        const float PREFETCH_LOOKAHEAD = 0.5f;
+        // ms without a move after which the cursor counts as stopped
+        const int PREFETCH_RATE_RESET = 1000;
+
         // return a list of files that were modified after the given timestamp
         std::vector<std::string> newFilesInDirSince(const std::string &path, const boost::posix_time::ptime &since)
         {
@@ -73,7 +86,7 @@ bool GuiGameList::isDetailed() const
 		if(!mFolder->getFile(i)->isFolder())
 		{
 			GameData* game = (GameData*)(mFolder->getFile(i));
-			if(game->metadata()->getSize("image") != 0)
+			if(game->metadata()->getSize(MDF_IMAGE) != 0)
 				return true;
 		}
 	}
@@ -92,9 +105,11 @@ GuiGameList::GuiGameList(Window* window) : GuiComponent(window),
 	mLastPlayed(window),
 	mReleaseDateLabel(window), 
 	mReleaseDate(window), 
-	mDescContainer(window), 
+	mDescContainer(window), mDescImageHeight(0),
 	mTransitionImage(window, 0.0f, 0.0f, "", (float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight(), true), 
 	mHeaderText(mWindow), 
+	mAllGames(NULL),
+	mPrefetchSelection(-1), mPrefetchStep(1), mTimeSinceMove(0), mScrollRate(0),
 	sortStateIndex(Settings::getInstance()->getInt("GameListSortIndex")),
 	mLockInput(false),
 	mEffectFunc(NULL), mEffectTime(0), mGameLaunchEffectLength(700)
@@ -111,6 +126,10 @@ GuiGameList::GuiGameList(Window* window) : GuiComponent(window),
 		sortStates.push_back(FolderData::SortState(FolderData::compareLastPlayed, false, "played most recently"));
 	}
 
+	//the saved index is used right away by updateList(), make sure it's valid
+	if(sortStateIndex >= sortStates.size())
+		sortStateIndex = 0;
+
         mLastPlayed.setDisplayMode(DateTimeComponent::DISP_RELATIVE_TO_NOW);
 
 	mDescContainer.addChild(&mReleaseDateLabel);
@@ -147,6 +166,7 @@ GuiGameList::GuiGameList(Window* window) : GuiComponent(window),
 GuiGameList::~GuiGameList()
 {
 	delete mTheme;
+	delete mAllGames;
         if (mScreenshot != nullptr)
         {
                 mImageAnimation.removeChild(mScreenshot);
@@ -171,29 +191,70 @@ void GuiGameList::setSystemId(int id)
 		return;
 	}
 
-	//make sure the id is within range
-	if(id >= (int)SystemData::sSystemVector.size())
-		id -= SystemData::sSystemVector.size();
+	//make sure the id is within range - the ids after the last system are the collections
+	int count = (int)(SystemData::sSystemVector.size() + mCollections.size());
+	if(id >= count)
+		id -= count;
 	if(id < 0)
-		id += SystemData::sSystemVector.size();
+		id += count;
 
 	mSystemId = id;
-	mSystem = SystemData::sSystemVector.at(mSystemId);
 
 	//clear the folder stack
 	while(mFolderStack.size()){ mFolderStack.pop(); }
 
-	mFolder = mSystem->getRootFolder();
+	if(id >= (int)SystemData::sSystemVector.size())
+	{
+		mSystem = NULL;
+		mFolder = mCollections.at(id - SystemData::sSystemVector.size());
+
+		//collections only know their games once they're sorted
+		const FolderData::SortState& sortState = getSortState();
+		mFolder->sort(sortState.comparisonFunction, sortState.ascending);
+
+		mTheme->setVar("SYSTEM_NAME", mFolder->getPath());
+		mTheme->setVar("SYSTEM_FULLNAME", mFolder->getName());
+		mTheme->setVar("SYSTEM_GAMECOUNT", std::to_string(mFolder->getFileCount()));
+	}else{
+		mSystem = SystemData::sSystemVector.at(mSystemId);
+		mFolder = mSystem->getRootFolder();
 
         mTheme->setVar("SYSTEM_NAME", mSystem->getName());
         mTheme->setVar("SYSTEM_FULLNAME", mSystem->getFullName());
         mTheme->setVar("SYSTEM_GAMECOUNT", std::to_string(mSystem->getGameCount()));
+	}
 	updateTheme();
 	updateList();
 	updateDetailData();
 	mWindow->normalizeNextUpdate(); //image loading can be slow
 }
 
+bool GuiGameList::isListEmpty(int id)
+{
+	//systems without games aren't loaded, only collections can be empty
+	if(id < (int)SystemData::sSystemVector.size())
+		return false;
+
+	//collections only know their games once they're sorted
+	FolderData* collection = mCollections.at(id - SystemData::sSystemVector.size());
+	const FolderData::SortState& sortState = getSortState();
+	collection->sort(sortState.comparisonFunction, sortState.ascending);
+	return collection->getFileCount() == 0;
+}
+
+int GuiGameList::getNextListId(int direction)
+{
+	int count = (int)(SystemData::sSystemVector.size() + mCollections.size());
+	for(int step = 1; step < count; step++)
+	{
+		int id = ((mSystemId + direction * step) % count + count) % count;
+		if(!isListEmpty(id))
+			return id;
+	}
+
+	return mSystemId;
+}
+
 void GuiGameList::render(const Eigen::Affine3f& parentTrans)
 {
 	Eigen::Affine3f trans = parentTrans * getTransform();
@@ -205,20 +266,26 @@ bool GuiGameList::input(InputConfig* config, Input input)
 	if(mLockInput)
 		return false;
 
-        mList.getSelectedObject()->setSelected(0);
+        if(mList.getSelectedObject())
+                mList.getSelectedObject()->setSelected(0);
 	mList.input(config, input);
-        mList.getSelectedObject()->setSelected(true);
+        if(mList.getSelectedObject())
+                mList.getSelectedObject()->setSelected(true);
 
 	if(input.id == SDLK_F3)
 	{
 		GameData* game = dynamic_cast<GameData*>(mList.getSelectedObject());
 		if(game)
 		{
-			FolderData* root = mSystem->getRootFolder();
+			SystemData* system = getSystemOf(game);
+			if(system == NULL)
+				return true;
+
+			FolderData* root = system->getRootFolder();
 			ScraperSearchParams searchParams;
 			searchParams.game = game;
-			searchParams.system = mSystem;
-			mWindow->pushGui(new GuiMetaDataEd(mWindow, game->metadata(), mSystem->getGameMDD(), searchParams, game->getBaseName(),
+			searchParams.system = system;
+			mWindow->pushGui(new GuiMetaDataEd(mWindow, game->metadata(), system->getGameMDD(), searchParams, game->getBaseName(),
 				[&] { updateDetailData(); }, 
 				[game, root, this] { 
 					boost::filesystem::remove(game->getPath());
@@ -235,6 +302,12 @@ bool GuiGameList::input(InputConfig* config, Input input)
 		return true;
 	}
 
+	if(input.id == SDLK_F6 && input.value != 0)
+	{
+		mWindow->pushGui(new GuiSearch(mWindow, this, mSystem, mTheme));
+		return true;
+	}
+
 	if(config->isMappedTo("a", input) && mFolder->getFileCount() > 0 && input.value != 0)
 	{
 		//play select sound
@@ -277,19 +350,16 @@ bool GuiGameList::input(InputConfig* config, Input input)
 		return true;
 	}
 
-	//only allow switching systems if more than one exists (otherwise it'll reset your position when you switch and it's annoying)
-	if(SystemData::sSystemVector.size() > 1 && input.value != 0)
+	//only allow switching systems if there's more than one list to switch to (otherwise it'll reset your position when you switch and it's annoying)
+	//empty collections don't count
+	if(input.value != 0 && (config->isMappedTo("right", input) || config->isMappedTo("left", input)))
 	{
-		if(config->isMappedTo("right", input))
-		{
-			setSystemId(mSystemId + 1);
-			doTransition(-1);
-			return true;
-		}
-		if(config->isMappedTo("left", input))
+		int direction = config->isMappedTo("right", input) ? 1 : -1;
+		int id = getNextListId(direction);
+		if(id != mSystemId)
 		{
-			setSystemId(mSystemId - 1);
-			doTransition(1);
+			setSystemId(id);
+			doTransition(-direction);
 			return true;
 		}
 	}
@@ -312,7 +382,7 @@ bool GuiGameList::input(InputConfig* config, Input input)
 	}
 
 	//open the fast select menu
-	if(config->isMappedTo("select", input) && input.value != 0)
+	if(config->isMappedTo("select", input) && mFolder->getFileCount() > 0 && input.value != 0)
 	{
         mWindow->pushGui(new GuiFastSelect(mWindow, this, &mList, mList.getSelectedObject()->getName()[0], mTheme));
 		return true;
@@ -347,7 +417,7 @@ void GuiGameList::setSortIndex(size_t index)
 	if (index != sortStateIndex) {
 		//get sort state from vector and sort list
 		sortStateIndex = index;
-		sort(sortStates.at(sortStateIndex).comparisonFunction, sortStates.at(sortStateIndex).ascending);
+		resort();
 	}
     //save new index to settings
     Settings::getInstance()->setInt("GameListSortIndex", sortStateIndex);
@@ -371,16 +441,78 @@ void GuiGameList::setPreviousSortIndex()
 	setSortIndex(sortStateIndex - 1);
 }
 
-void GuiGameList::sort(FolderData::ComparisonFunction & comparisonFunction, bool ascending)
+void GuiGameList::resort()
 {
-	//resort list and update it
-	mFolder->sort(comparisonFunction, ascending);
+	//the list sorts the folder it shows, by getSortState()
 	updateList();
 	updateDetailData();
 }
 
+SystemData* GuiGameList::getSystemOf(GameData* game) const
+{
+	return mFolder->getSystem(game);
+}
+
+void GuiGameList::showGame(SystemData* system, GameData* game)
+{
+	auto it = std::find(SystemData::sSystemVector.begin(), SystemData::sSystemVector.end(), system);
+	if(it == SystemData::sSystemVector.end())
+		return;
+
+	if(system != mSystem)
+		setSystemId(it - SystemData::sSystemVector.begin());
+
+	//the game's directory ends with a separator, the folder's path doesn't
+	const std::string& directory = game->getDirectory();
+	std::vector<FolderData*> chain;
+	if(!system->getFolderChain(directory.substr(0, directory.length() - 1), chain))
+		return;
+
+	while(mFolderStack.size()){ mFolderStack.pop(); }
+	mFolder = chain.front();
+	for(unsigned int i = 1; i < chain.size(); i++)
+	{
+		mFolderStack.push(mFolder);
+		mFolder = chain.at(i);
+	}
+
+	if(mList.getSelectedObject())
+		mList.getSelectedObject()->setSelected(0);
+	game->setSelected(true);
+
+	updateList();
+	for(int i = 0; i < mList.getObjectCount(); i++)
+	{
+		if(mList.getObject(i) == game)
+		{
+			mList.setSelection(i);
+			break;
+		}
+	}
+	updateDetailData();
+}
+
+void GuiGameList::updateCollections()
+{
+	mCollections.clear();
+	delete mAllGames;
+	mAllGames = NULL;
+
+	//the collections come after the last system - with more than one system, the games of all of them can be browsed together
+	if(SystemData::sSystemVector.size() > 1)
+	{
+		mAllGames = new AllGamesFolder(SystemData::sSystemVector);
+		mCollections.push_back(mAllGames);
+	}
+	mCollections.push_back(PlayedGamesFolder::getInstance(PlayedGamesFolder::RECENTLY_PLAYED));
+	mCollections.push_back(PlayedGamesFolder::getInstance(PlayedGamesFolder::MOST_PLAYED));
+}
+
 void GuiGameList::reselectSystem()
 {
+        //the systems may have been loaded again, All Games must not refer to the old ones
+        updateCollections();
+
         boost::posix_time::ptime lastSelectionTime = boost::date_time::min_date_time;
         int lastSelectedSystemId = 0;
         for (unsigned int systemId = 0; systemId < SystemData::sSystemVector.size(); ++systemId)
@@ -400,6 +532,10 @@ void GuiGameList::updateList()
 {
 	mList.clear();
 
+	//folders are only sorted when they're shown (and only if they aren't already in this order)
+	const FolderData::SortState& sortState = getSortState();
+	mFolder->sort(sortState.comparisonFunction, sortState.ascending);
+
         unsigned int selectId = 0;
         boost::posix_time::ptime selectIdSelectionTime(boost::date_time::min_date_time);
 	for(unsigned int i = 0; i < mFolder->getFileCount(); i++)
@@ -417,6 +553,9 @@ void GuiGameList::updateList()
 			mList.addObject(file->getName(), file, mTheme->getColor("primary"));
 	}
         mList.setSelection(selectId);
+
+	//the entries around the selection are different ones now
+	mPrefetchSelection = -1;
 }
 
 std::string GuiGameList::getThemeFile()
@@ -424,13 +563,16 @@ std::string GuiGameList::getThemeFile()
 	std::string themePath;
 
 	themePath = getHomePath();
-	themePath += "/.emulationstation/" +  mSystem->getName() + "/theme.xml";
+	themePath += "/.emulationstation/" + (mSystem ? mSystem->getName() : mFolder->getPath()) + "/theme.xml";
 	if(boost::filesystem::exists(themePath))
 		return themePath;
 
-	themePath = mSystem->getStartPath() + "/theme.xml";
-	if(boost::filesystem::exists(themePath))
-		return themePath;
+	if(mSystem)
+	{
+		themePath = mSystem->getStartPath() + "/theme.xml";
+		if(boost::filesystem::exists(themePath))
+			return themePath;
+	}
 
 	themePath = getHomePath();
 	themePath += "/.emulationstation/es_theme.xml";
@@ -453,7 +595,7 @@ void GuiGameList::updateTheme()
 
 	if(!mTheme->getBool("hideHeader"))
 	{
-		mHeaderText.setText(mSystem->getFullName());
+		mHeaderText.setText(mSystem ? mSystem->getFullName() : mFolder->getName());
 	}else{
 		mHeaderText.setText("");
 	}
@@ -549,12 +691,11 @@ void GuiGameList::updateDetailData()
 
 		GameData* game = (GameData*)mList.getSelectedObject();
 
-                float gameImageYOffset = 0.f;
                 Eigen::Vector3f imgOffset = Eigen::Vector3f(Renderer::getScreenWidth() * 0.10f, 0, 0);
                 if (mScreenshot != nullptr)
                 {
                         //set image to either "not found" image or metadata image
-                        if(game->metadata()->getSize("image") == 0 || !boost::filesystem::exists(game->metadata()->getElemAt("image", 0)))
+                        if(game->metadata()->getSize(MDF_IMAGE) == 0 || !boost::filesystem::exists(game->metadata()->getElemAt(MDF_IMAGE, 0)))
                         {
                                 //image doesn't exist
                                 if(mTheme->getString("imageNotFoundPath").empty())
@@ -566,11 +707,10 @@ void GuiGameList::updateDetailData()
                                         mScreenshot->setImage(mTheme->getString("imageNotFoundPath"));
                                 }
                         }else{
-                                mScreenshot->setImage(game->metadata()->getElemAt("image", 0));
+                                mScreenshot->setImage(game->metadata()->getElemAt(MDF_IMAGE, 0));
                         }
 
                         mScreenshot->setPosition(getImagePos() - imgOffset);
-                        gameImageYOffset = getImagePos().y() + mScreenshot->getSize().y();
                 } else if (mScreenshots != nullptr) {
                         // remove old images
                         while (mScreenshots->getChildCount() > 0)
@@ -580,33 +720,31 @@ void GuiGameList::updateDetailData()
                                 delete p;
                         }
                         //set image to either "not found" image or metadata image
-                        if(game->metadata()->getSize("image") == 0)
+                        if(game->metadata()->getSize(MDF_IMAGE) == 0)
                         {
                                 if (!mTheme->getString("imageNotFoundPath").empty())
                                 {
                                         ImageComponent *ic = new ImageComponent(mWindow);
-                                        ic->setImage(mTheme->getString("imageNotFoundPath"));
                                         mScreenshots->addImage(ic);
+                                        ic->setImage(mTheme->getString("imageNotFoundPath"));
                                 }
                         } else {
-                                for (unsigned int i=0; i<game->metadata()->getSize("image"); ++i)
+                                for (unsigned int i=0; i<game->metadata()->getSize(MDF_IMAGE); ++i)
                                 {
                                         ImageComponent *ic = new ImageComponent(mWindow);
-                                        ic->setImage(game->metadata()->getElemAt("image", i));
                                         mScreenshots->addImage(ic);
+                                        ic->setImage(game->metadata()->getElemAt(MDF_IMAGE, i));
                                 }
                         }
 
                         mScreenshots->setPosition(getImagePos() - imgOffset); 
                         mScreenshots->reset();
-                        gameImageYOffset = getImagePos().y() + mScreenshots->getSize().y();
                 }
 
 		mImageAnimation.fadeIn(35);
 		mImageAnimation.move((int)imgOffset.x(), (int)imgOffset.y(), 20);
 
-		mDescContainer.setPosition(Eigen::Vector3f(Renderer::getScreenWidth() * 0.03f, gameImageYOffset + 12, 0));
-		mDescContainer.setSize(Eigen::Vector2f(Renderer::getScreenWidth() * (mTheme->getFloat("listOffsetX") - 0.03f), Renderer::getScreenHeight() - mDescContainer.getPosition().y()));
+		placeDescription();
 		mDescContainer.setScrollPos(Eigen::Vector2d(0, 0));
 		mDescContainer.resetAutoScrollTimer();
 
@@ -634,6 +772,24 @@ void GuiGameList::updateDetailData()
 	}
 }
 
+void GuiGameList::placeDescription()
+{
+	float gameImageYOffset = 0.f;
+	mDescImageHeight = 0.f;
+	if(mScreenshot != nullptr)
+	{
+		mDescImageHeight = mScreenshot->getSize().y();
+		gameImageYOffset = getImagePos().y() + mDescImageHeight;
+	}else if(mScreenshots != nullptr)
+	{
+		mDescImageHeight = mScreenshots->getSize().y();
+		gameImageYOffset = getImagePos().y() + mDescImageHeight;
+	}
+
+	mDescContainer.setPosition(Eigen::Vector3f(Renderer::getScreenWidth() * 0.03f, gameImageYOffset + 12, 0));
+	mDescContainer.setSize(Eigen::Vector2f(Renderer::getScreenWidth() * (mTheme->getFloat("listOffsetX") - 0.03f), Renderer::getScreenHeight() - mDescContainer.getPosition().y()));
+}
+
 void GuiGameList::hideDetailData()
 {
 	if(mDescContainer.getParent() == this)
@@ -651,6 +807,14 @@ GuiGameList* GuiGameList::create(Window* window)
 
 void GuiGameList::update(int deltaTime)
 {
+	//don't touch the list while a game is being launched, the effect needs the selected game
+	if(mEffectFunc == NULL)
+	{
+		std::vector<LibraryWatcher::Change> changes = LibraryWatcher::getInstance()->takeChanges();
+		if(!changes.empty())
+			applyLibraryChanges(changes);
+	}
+
 	mTransitionAnimation.update(deltaTime);
 	mImageAnimation.update(deltaTime);
 
@@ -661,6 +825,178 @@ void GuiGameList::update(int deltaTime)
 	}
 
 	GuiComponent::update(deltaTime);
+
+	trackCursor(deltaTime);
+
+	//game images load in the background, the description moves once the image knows its size
+	if(mScreenshot != nullptr && mDescContainer.getParent() == this && mScreenshot->getSize().y() != mDescImageHeight)
+		placeDescription();
+}
+
+void GuiGameList::trackCursor(int deltaTime)
+{
+	mTimeSinceMove += deltaTime;
+
+	//after a pause the next move starts slow again
+	if(mTimeSinceMove > PREFETCH_RATE_RESET)
+		mScrollRate = 0;
+
+	const int selection = mList.getSelection();
+	if(selection == mPrefetchSelection || mList.getObjectCount() == 0)
+		return;
+
+	//isDetailed() looks at every game, so only once per move - a list without images has nothing to prefetch
+	if(!isDetailed())
+	{
+		mPrefetchSelection = selection;
+		return;
+	}
+
+	if(mPrefetchSelection >= 0)
+	{
+		//the list wraps around, the shorter way is the one the cursor went
+		const int count = mList.getObjectCount();
+		int step = selection - mPrefetchSelection;
+		if(step > count / 2)
+			step -= count;
+		else if(step < -count / 2)
+			step += count;
+
+		if(step != 0)
+			mPrefetchStep = step;
+
+		float rate = abs(step) * 1000.0f / (float)std::max(mTimeSinceMove, 1);
+		mScrollRate = mScrollRate * 0.5f + rate * 0.5f;
+	}
+
+	mTimeSinceMove = 0;
+	mPrefetchSelection = selection;
+	prefetchImages();
+}
+
+void GuiGameList::prefetchImages()
+{
+	//whatever wasn't started yet was for where the cursor used to be
+	TextureLoader::getInstance()->cancelPrefetches();
+
+	std::vector< std::shared_ptr<TextureResource> > prefetched;
+
+	const int maxDepth = Settings::getInstance()->getInt("PrefetchDepth");
+	if(maxDepth > 0)
+	{
+		//ahead as far as the cursor gets in a little while, behind just a bit in case it turns around
+		int ahead = std::min(PREFETCH_MIN_DEPTH + (int)(mScrollRate * PREFETCH_LOOKAHEAD), maxDepth);
+		int behind = std::max(ahead / 4, 1);
+
+		const int count = mList.getObjectCount();
+		for(int i = 1; i <= ahead; i++)
+		{
+			//closest first, they're loaded in the order they're asked for
+			prefetchImagesOf(mList.getObject(((mPrefetchSelection + mPrefetchStep * i) % count + count) % count), prefetched);
+			if(i <= behind)
+				prefetchImagesOf(mList.getObject(((mPrefetchSelection - mPrefetchStep * i) % count + count) % count), prefetched);
+		}
+	}
+
+	mPrefetched.swap(prefetched);
+}
+
+void GuiGameList::prefetchImagesOf(FileData* file, std::vector< std::shared_ptr<TextureResource> >& prefetched)
+{
+	if(file->isFolder())
+		return;
+
+	//the same images updateDetailData() is going to show, at the size they're going to be shown with
+	MetaDataList* metadata = ((GameData*)file)->metadata();
+	unsigned int images = (mScreenshots != nullptr) ? metadata->getSize(MDF_IMAGE) : std::min(metadata->getSize(MDF_IMAGE), 1u);
+	const Eigen::Vector2i targetSize = getGameImageLoadSize();
+	for(unsigned int i = 0; i < images; i++)
+	{
+		std::shared_ptr<TextureResource> texture = TextureResource::prefetch(metadata->getElemAt(MDF_IMAGE, i), targetSize);
+		if(texture)
+			prefetched.push_back(texture);
+	}
+}
+
+Eigen::Vector2i GuiGameList::getGameImageLoadSize() const
+{
+	//what the ImageComponents of updateDetailData() ask for
+	if(mScreenshots != nullptr)
+		return Eigen::Vector2i((int)ceil(mScreenshots->getSize().x()), 0);
+
+	return Eigen::Vector2i((int)ceil(mTheme->getFloat("gameImageWidth") * Renderer::getScreenWidth()),
+		(int)ceil(mTheme->getFloat("gameImageHeight") * Renderer::getScreenHeight()));
+}
+
+unsigned int GuiGameList::buildThumbnails()
+{
+	unsigned int total = 0;
+	for(unsigned int i = 0; i < SystemData::sSystemVector.size(); i++)
+	{
+		//loads the system's theme, the image size depends on it
+		setSystemId(i);
+		if(!isDetailed())
+			continue;
+
+		const Eigen::Vector2i targetSize = getGameImageLoadSize();
+		const bool multi = mScreenshots != nullptr;
+		unsigned int added = 0;
+		mSystem->getRootFolder()->visitGames([&](GameData* game) {
+			MetaDataList* metadata = game->metadata();
+			unsigned int images = multi ? metadata->getSize(MDF_IMAGE) : std::min(metadata->getSize(MDF_IMAGE), 1u);
+			for(unsigned int j = 0; j < images; j++)
+			{
+				if(ThumbnailCache::getInstance()->build(metadata->getElemAt(MDF_IMAGE, j), targetSize.x(), targetSize.y()))
+					added++;
+			}
+		});
+
+		std::cout << mSystem->getFullName() << ": " << added << " images added\n";
+		total += added;
+	}
+
+	return total;
+}
+
+void GuiGameList::applyLibraryChanges(const std::vector<LibraryWatcher::Change>& changes)
+{
+	bool listChanged = false;
+	for(auto it = changes.begin(); it != changes.end(); it++)
+	{
+		FolderData* folder = it->system->applyFileChange(it->path);
+		if(folder)
+		{
+			LOG(LogInfo) << "Library change in " << it->system->getName() << ": \"" << it->path << "\"";
+			if(it->system == mSystem || mSystem == NULL)
+				listChanged = true;
+		}
+	}
+
+	if(!listChanged)
+		return;
+
+	//the folder we're in (or one above it) may have been removed, walk down from the root as far as everything still exists
+	std::vector<FolderData*> path;
+	std::stack<FolderData*> stack = mFolderStack;
+	while(!stack.empty())
+	{
+		path.insert(path.begin(), stack.top());
+		stack.pop();
+	}
+	path.push_back(mFolder);
+
+	unsigned int valid = 1; //the root folder is never removed
+	while(valid < path.size() && path.at(valid - 1)->getSubfolder(path.at(valid)->getPath()) == path.at(valid))
+		valid++;
+
+	while(!mFolderStack.empty())
+		mFolderStack.pop();
+	for(unsigned int i = 0; i + 1 < valid; i++)
+		mFolderStack.push(path.at(i));
+	mFolder = path.at(valid - 1);
+
+	updateList();
+	updateDetailData();
 }
 
 void GuiGameList::doTransition(int dir)
@@ -754,8 +1090,16 @@ void GuiGameList::updateGameLaunchEffect(int t)
 		//effect done
 		mTransitionImage.setImage(""); //fixes "tried to bind uninitialized texture!" since copyScreen()'d textures don't reinit
                 boost::posix_time::ptime time = boost::posix_time::second_clock::universal_time();
-		mSystem->launchGame(mWindow, (GameData*)mList.getSelectedObject());
-                importFreshScreenshots(time);
+		GameData* game = (GameData*)mList.getSelectedObject();
+		SystemData* system = getSystemOf(game);
+		if(system)
+		{
+			unsigned int generation = game->metadata()->getGeneration();
+			system->launchGame(mWindow, game);
+			importFreshScreenshots(system, time);
+			if(mAllGames)
+				mAllGames->updateGame(game, generation); //only this game moved, the merged orders don't need to be rebuilt
+		}
                 updateDetailData(); // update metadata that may be used in theme (e.g. last played timestamp, new screenshots etc.)
 		mEffectFunc = &GuiGameList::updateGameReturnEffect;
 		mEffectTime = 0;
@@ -772,12 +1116,12 @@ void GuiGameList::updateGameReturnEffect(int t)
 		mEffectFunc = NULL;
 }
 
-void GuiGameList::importFreshScreenshots(const boost::posix_time::ptime &since)
+void GuiGameList::importFreshScreenshots(SystemData* system, const boost::posix_time::ptime &since)
 {
-        if (mSystem->getEmulatorScreenshotDumpDir().empty() || mSystem->getScreenshotDir().empty())
+        if (system->getEmulatorScreenshotDumpDir().empty() || system->getScreenshotDir().empty())
                 return; // not configured
 
-        std::vector<std::string> newScreenshots(newFilesInDirSince(mSystem->getEmulatorScreenshotDumpDir(), since));
+        std::vector<std::string> newScreenshots(newFilesInDirSince(system->getEmulatorScreenshotDumpDir(), since));
         if (newScreenshots.empty())
                 return; // no new screenshots found
 
@@ -786,7 +1130,7 @@ void GuiGameList::importFreshScreenshots(const boost::posix_time::ptime &since)
                 return; // impossible
 
 	LOG(LogInfo) << "Found " << newScreenshots.size() << " new screenshots for game " << game->getName() << std::endl;
-        newScreenshots = moveAndRenameFiles(newScreenshots, game->getBaseName(), mSystem->getScreenshotDir());
+        newScreenshots = moveAndRenameFiles(newScreenshots, game->getBaseName(), system->getScreenshotDir());
         for (auto fname: newScreenshots)
-                game->metadata()->push_back("image", fname);
+                game->metadata()->push_back(MDF_IMAGE, fname);
 }
@@ -11,6 +11,8 @@
 #include "../SystemData.h"
 #include "../GameData.h"
 #include "../FolderData.h"
+#include "../LibraryWatcher.h"
+#include "../AllGamesFolder.h"
 #include "TextListComponent.h"
 #include "ScrollableContainer.h"
 #include "VerticalImageAutoScrollbox.h"
@@ -29,6 +31,7 @@ public:
 	virtual ~GuiGameList();
 
 	void setSystemId(int id);
+	//Selects the system last used. Call it after the systems were loaded again, the collections are rebuilt.
         void reselectSystem();
 
 	bool input(InputConfig* config, Input input) override;
@@ -37,30 +40,58 @@ public:
 
 	void updateDetailData();
 
+	//Switches to system and opens the folders down to game, with game selected.
+	void showGame(SystemData* system, GameData* game);
+
     const FolderData::SortState & getSortState() const;
 	void setSortIndex(size_t index);
 	void setNextSortIndex();
 	void setPreviousSortIndex();
-	void sort(FolderData::ComparisonFunction & comparisonFunction = FolderData::compareFileName, bool ascending = true);
+	void resort(); //shows the list in the current sort state again
 
 	static GuiGameList* create(Window* window);
 
+	//Fills the ThumbnailCache with the game images of every system, at the size this list shows them with. Returns the
+	//number of images added.
+	unsigned int buildThumbnails();
+
 	bool isDetailed() const;
 
 	static const float sInfoWidth;
 private:
 	void updateList();
+	void updateCollections(); //from SystemData::sSystemVector
+	bool isListEmpty(int id); //ids are the ones of setSystemId()
+	int getNextListId(int direction); //the next list in direction (1 or -1) that isn't empty, mSystemId if there is none
+	void applyLibraryChanges(const std::vector<LibraryWatcher::Change>& changes);
 	void updateTheme();
 	void hideDetailData();
 	void doTransition(int dir);
         // check the screenshot dump directory and add new screenshots to the game
-        void importFreshScreenshots(const boost::posix_time::ptime &since);
+        void importFreshScreenshots(SystemData* system, const boost::posix_time::ptime &since);
+
+	//the system a game in the list belongs to - mSystem, unless a collection is shown
+	SystemData* getSystemOf(GameData* game) const;
+
+	//loads the images of the games the cursor is heading to in the background, more of them the faster it moves
+	void trackCursor(int deltaTime);
+	void prefetchImages();
+	void prefetchImagesOf(FileData* file, std::vector< std::shared_ptr<TextureResource> >& prefetched);
+	Eigen::Vector2i getGameImageLoadSize() const; //the size the game images are decoded for with the current theme
+
+	std::vector< std::shared_ptr<TextureResource> > mPrefetched; //kept so they aren't evicted before they're shown
+	int mPrefetchSelection; //the list entry prefetched around, -1 after the list changed
+	int mPrefetchStep; //the last cursor move, its direction and stride are where the cursor is heading
+	int mTimeSinceMove;
+	float mScrollRate; //list entries per second, averaged over the last few moves
 
 
 	std::string getThemeFile();
 
-	SystemData* mSystem;
+	SystemData* mSystem; //NULL while a collection is shown
 	FolderData* mFolder;
+	std::vector<FolderData*> mCollections; //shown after the systems
+	AllGamesFolder* mAllGames; //NULL with only one system
 	std::stack<FolderData*> mFolderStack;
 	int mSystemId;
 
@@ -75,6 +106,8 @@ private:
 	DateTimeComponent mReleaseDate;
 
 	ScrollableContainer mDescContainer;
+	float mDescImageHeight; //the game image height the description was placed below
+	void placeDescription();
 	AnimationComponent mImageAnimation;
 	ThemeComponent* mTheme;
 	TextComponent mHeaderText;
@@ -120,6 +120,9 @@ void GuiMetaDataEd::save()
 		mMetaData->set(mLabels.at(i)->getValue(), mEditors.at(i)->getValue());
 	}
 
+	if(mScraperParams.system && mScraperParams.game)
+		mScraperParams.system->updateSearchIndex(mScraperParams.game);
+
 	if(mSavedCallback)
 		mSavedCallback();
 }
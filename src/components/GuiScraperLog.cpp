@@ -4,6 +4,7 @@
 #include "../Renderer.h"
 #include "../Log.h"
 #include "../XMLReader.h"
+#include "../GamelistWriter.h"
 
 GuiScraperLog::GuiScraperLog(Window* window, const std::queue<ScraperSearchParams>& searches, bool manualMode) : GuiComponent(window), 
 	mManualMode(manualMode), 
@@ -88,11 +89,12 @@ void GuiScraperLog::resultResolved(ScraperSearchParams params, MetaDataList mdl)
 {
 	//apply new metadata
 	*params.game->metadata() = mdl;
+	params.system->updateSearchIndex(params.game);
 
 	writeLine("   Success!", 0x00FF00FF);
 
-	//write changes to gamelist.xml
-	updateGamelist(params.system);
+	//write changes to gamelist.xml, in the background - they are collected for a few seconds and written together
+	GamelistWriter::getInstance()->queue(params.system);
 
 	mSuccessCount++;
 
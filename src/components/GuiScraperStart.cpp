@@ -26,7 +26,7 @@ GuiScraperStart::GuiScraperStart(Window* window) : GuiComponent(window),
 	mFiltersOpt.addEntry(mFiltersOpt.makeEntry("All Games", 
 		[](SystemData*, GameData*) -> bool { return true; }, true));
 	mFiltersOpt.addEntry(mFiltersOpt.makeEntry("Missing Image", 
-		[](SystemData*, GameData* g) -> bool { return g->metadata()->get("image").empty(); }));
+		[](SystemData*, GameData* g) -> bool { return g->metadata()->getSize(MDF_IMAGE) == 0; }));
 
 	mList.setEntry(Vector2i(0, 0), Vector2i(1, 1), &mFilterLabel, false, ComponentListComponent::AlignRight);
 	mList.setEntry(Vector2i(1, 0), Vector2i(1, 1), &mFiltersOpt, true, ComponentListComponent::AlignLeft);
@@ -85,18 +85,17 @@ std::queue<ScraperSearchParams> GuiScraperStart::getSearches(std::vector<SystemD
 	std::queue<ScraperSearchParams> queue;
 	for(auto sys = systems.begin(); sys != systems.end(); sys++)
 	{
-		std::vector<FileData*> games = (*sys)->getRootFolder()->getFilesRecursive(true);
-		for(auto game = games.begin(); game != games.end(); game++)
-		{
-			if(selector((*sys), (GameData*)(*game)))
+		SystemData* system = *sys;
+		system->getRootFolder()->visitGames([&](GameData* game) {
+			if(selector(system, game))
 			{
 				ScraperSearchParams search;
-				search.game = (GameData*)(*game);
-				search.system = *sys;
+				search.game = game;
+				search.system = system;
 				
 				queue.push(search);
 			}
-		}
+		});
 	}
 
 	return queue;
@@ -0,0 +1,158 @@
+#include "GuiSearch.h"
+#include "GuiGameList.h"
+#include "../Renderer.h"
+#include <SDL.h>
+
+#define DEFAULT_FS_IMAGE ":/frame.png"
+
+//more rows than this aren't worth scrolling through, typing another letter is quicker
+const size_t GuiSearch::MAX_RESULTS = 100;
+
+GuiSearch::GuiSearch(Window* window, GuiGameList* parent, SystemData* system, ThemeComponent* theme)
+	: GuiComponent(window), mParent(parent), mSystem(system), mTheme(theme), mBox(mWindow, ""),
+	mList(window, 0.0f, 0.0f, theme->getListFont()), mAllSystems(system == NULL)
+{
+	mTextColor = mTheme->getColor("fastSelect");
+
+	unsigned int sw = Renderer::getScreenWidth(), sh = Renderer::getScreenHeight();
+
+	if(theme->getString("fastSelectFrame").empty())
+	{
+		mBox.setImagePath(DEFAULT_FS_IMAGE);
+		mBox.setEdgeColor(0x005493FF);
+		mBox.setCenterColor(0x5e5e5eFF);
+	}else{
+		mBox.setImagePath(theme->getString("fastSelectFrame"));
+	}
+
+	mBox.setPosition(sw * 0.1f, sh * 0.1f);
+	mBox.setSize(sw * 0.8f, sh * 0.8f);
+
+	//two lines of text above the list: the query and what is searched
+	float textHeight = mTheme->getDescriptionFont()->getHeight() * 2.5f;
+	mList.setSelectorColor(mTheme->getColor("selector"));
+	mList.setSelectedTextColor(mTheme->getColor("selected"));
+	mList.setScrollSound(mTheme->getSound("menuScroll"));
+	mList.setPosition(sw * 0.12f, sh * 0.12f + textHeight);
+	mList.setSize(sw * 0.76f, sh * 0.76f - textHeight);
+
+	SDL_StartTextInput();
+}
+
+GuiSearch::~GuiSearch()
+{
+	SDL_StopTextInput();
+}
+
+void GuiSearch::textInput(const char* text)
+{
+	if(text[0] == '\b')
+	{
+		//remove a whole UTF-8 sequence
+		while(!mQuery.empty() && (mQuery[mQuery.length() - 1] & 0xC0) == 0x80)
+			mQuery.erase(mQuery.length() - 1);
+		if(!mQuery.empty())
+			mQuery.erase(mQuery.length() - 1);
+	}else{
+		mQuery += text;
+	}
+
+	updateResults();
+}
+
+void GuiSearch::updateResults()
+{
+	mList.clear();
+	mResultSystems.clear();
+
+	std::vector<SystemData*> systems;
+	if(mAllSystems)
+		systems = SystemData::sSystemVector;
+	else
+		systems.push_back(mSystem);
+
+	for(auto it = systems.begin(); it != systems.end() && mResultSystems.size() < MAX_RESULTS; it++)
+	{
+		std::vector<GameData*> games;
+		(*it)->getSearchIndex().find(mQuery, games, MAX_RESULTS - mResultSystems.size());
+
+		for(auto game = games.begin(); game != games.end(); game++)
+		{
+			std::string name = (*game)->getName();
+			if(mAllSystems)
+				name += " [" + (*it)->getName() + "]";
+
+			mList.addObject(name, *game, mTheme->getColor("primary"));
+			mResultSystems.push_back(*it);
+		}
+	}
+}
+
+bool GuiSearch::input(InputConfig* config, Input input)
+{
+	if(config->isMappedTo("up", input) || config->isMappedTo("down", input))
+	{
+		mList.input(config, input);
+		return true;
+	}
+
+	if(input.value == 0)
+		return true;
+
+	if(mSystem && (config->isMappedTo("left", input) || config->isMappedTo("right", input)))
+	{
+		mAllSystems = !mAllSystems;
+		updateResults();
+		mTheme->getSound("menuScroll")->play();
+		return true;
+	}
+
+	if(config->isMappedTo("a", input))
+	{
+		if(mList.getObjectCount() > 0)
+		{
+			mTheme->getSound("menuSelect")->play();
+			mParent->showGame(mResultSystems.at(mList.getSelection()), mList.getSelectedObject());
+			delete this;
+		}
+		return true;
+	}
+
+	if(config->isMappedTo("b", input) || input.id == SDLK_F6)
+	{
+		mTheme->getSound("menuBack")->play();
+		delete this;
+		return true;
+	}
+
+	return true;
+}
+
+void GuiSearch::update(int deltaTime)
+{
+	mList.update(deltaTime);
+}
+
+void GuiSearch::render(const Eigen::Affine3f& parentTrans)
+{
+	Eigen::Affine3f trans = parentTrans * getTransform();
+
+	unsigned int sw = Renderer::getScreenWidth(), sh = Renderer::getScreenHeight();
+
+	mBox.render(trans);
+
+	Renderer::setMatrix(trans);
+	std::shared_ptr<Font> font = mTheme->getDescriptionFont();
+
+	font->drawText("Search: " + mQuery + "_", Eigen::Vector2f(sw * 0.12f, sh * 0.12f), mTextColor);
+
+	std::string scope = mAllSystems ? "all systems" : mSystem->getFullName();
+	if(mSystem)
+		scope = "<- " + scope + " ->";
+	font->drawText(scope, Eigen::Vector2f(sw * 0.12f, sh * 0.12f + font->getHeight()), mTextColor);
+
+	if(mList.getObjectCount() > 0)
+		mList.render(trans);
+	else if(!mQuery.empty())
+		font->drawCenteredText("No games found.", 0, sh * 0.5f - (font->getHeight() * 0.5f), mTextColor);
+}
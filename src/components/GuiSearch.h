@@ -0,0 +1,46 @@
+#ifndef _GUISEARCH_H_
+#define _GUISEARCH_H_
+
+#include "../GuiComponent.h"
+#include "../SystemData.h"
+#include "../GameData.h"
+#include "ThemeComponent.h"
+#include "TextListComponent.h"
+#include "NinePatchComponent.h"
+
+class GuiGameList;
+
+//Type-to-search: every key typed narrows down a list of games whose names contain what was typed.
+//Searches the system shown in the game list, left/right switches between that and all systems.
+//Without a system (while the game list shows all games), all systems are searched.
+class GuiSearch : public GuiComponent
+{
+public:
+	GuiSearch(Window* window, GuiGameList* parent, SystemData* system, ThemeComponent* theme);
+	~GuiSearch();
+
+	bool input(InputConfig* config, Input input) override;
+	void textInput(const char* text) override;
+	void update(int deltaTime) override;
+	void render(const Eigen::Affine3f& parentTrans) override;
+
+private:
+	static const size_t MAX_RESULTS;
+
+	void updateResults();
+
+	GuiGameList* mParent;
+	SystemData* mSystem;
+	ThemeComponent* mTheme;
+	NinePatchComponent mBox;
+
+	TextListComponent<GameData*> mList;
+	std::vector<SystemData*> mResultSystems; //the system of each row of mList
+
+	std::string mQuery;
+	bool mAllSystems;
+
+	unsigned int mTextColor;
+};
+
+#endif
@@ -20,7 +20,8 @@ Eigen::Vector2f ImageComponent::getCenter() const
 }
 
 ImageComponent::ImageComponent(Window* window, float offsetX, float offsetY, std::string path, float targetWidth, float targetHeight, bool allowUpscale) : GuiComponent(window), 
-	mTiled(false), mAllowUpscale(allowUpscale), mFlipX(false), mFlipY(false), mOrigin(0.5, 0.5), mTargetSize(targetWidth, targetHeight), mColorShift(0xFFFFFFFF)
+	mTiled(false), mAllowUpscale(allowUpscale), mFlipX(false), mFlipY(false), mOrigin(0.5, 0.5), mTargetSize(targetWidth, targetHeight), mColorShift(0xFFFFFFFF),
+	mResizedTextureSize(Eigen::Vector2i::Zero())
 {
 	setPosition(offsetX, offsetY);
 
@@ -34,9 +35,15 @@ ImageComponent::~ImageComponent()
 
 void ImageComponent::resize()
 {
+	mResizedTextureSize = getTextureSize();
+
 	if(!mTexture)
 		return;
 
+	//still loading - keep the old size until there's something to scale, so the layout around us doesn't jump
+	if(!mTiled && mResizedTextureSize == Eigen::Vector2i::Zero())
+		return;
+
 	mSize << (float)getTextureSize().x(), (float)getTextureSize().y();
 	
 	//(we don't resize tiled images)
@@ -68,20 +75,37 @@ void ImageComponent::resize()
 		mSize = mTargetSize;
 }
 
-void ImageComponent::setImage(std::string path)
+Eigen::Vector2i ImageComponent::getLoadSize() const
 {
-	mPath = path;
+	//tiles are drawn at the size of the image
+	if(mTiled)
+		return Eigen::Vector2i::Zero();
 
+	return Eigen::Vector2i((int)ceil(mTargetSize.x()), (int)ceil(mTargetSize.y()));
+}
+
+void ImageComponent::requestTexture()
+{
 	if(mPath.empty() || !ResourceManager::getInstance()->fileExists(mPath))
 		mTexture.reset();
 	else
-		mTexture = TextureResource::get(mPath);
+		mTexture = TextureResource::get(mPath, true, getLoadSize());
+
+	//tiles repeat the texture, they can't come from the atlas
+	if(mTexture && mTiled)
+		mTexture->requireRepeat();
+}
 
+void ImageComponent::setImage(std::string path)
+{
+	mPath = path;
+	requestTexture();
 	resize();
 }
 
 void ImageComponent::setImage(const char* path, size_t length)
 {
+	mPath = "";
 	mTexture.reset();
 
 	mTexture = TextureResource::get("");
@@ -102,6 +126,10 @@ void ImageComponent::setTiling(bool tile)
 	if(mTiled)
 		mAllowUpscale = false;
 
+	//a tiled texture needs every pixel
+	if(mTexture && !mPath.empty())
+		requestTexture();
+
 	resize();
 }
 
@@ -109,6 +137,10 @@ void ImageComponent::setResize(float width, float height, bool allowUpscale)
 {
 	mTargetSize << width, height;
 	mAllowUpscale = allowUpscale;
+
+	if(mTexture && !mPath.empty())
+		requestTexture();
+
 	resize();
 }
 
@@ -127,12 +159,22 @@ void ImageComponent::setColorShift(unsigned int color)
 	mColorShift = color;
 }
 
+void ImageComponent::update(int deltaTime)
+{
+	//the texture finished loading since the last resize
+	if(getTextureSize() != mResizedTextureSize)
+		resize();
+
+	GuiComponent::update(deltaTime);
+}
+
 void ImageComponent::render(const Eigen::Affine3f& parentTrans)
 {
 	Eigen::Affine3f trans = parentTrans * getTransform();
 	Renderer::setMatrix(trans);
 	
-	if(mTexture && getOpacity() > 0)
+	//a tiled image still in the atlas is about to get a texture of its own
+	if(mTexture && mTexture->isInitialized() && getOpacity() > 0 && !(mTiled && mTexture->isAtlased()))
 	{
 		GLfloat points[12], texs[12];
 		GLubyte colors[6*4];
@@ -147,6 +189,16 @@ void ImageComponent::render(const Eigen::Affine3f& parentTrans)
 		}else{
 			Renderer::buildGLColorArray(colors, (mColorShift >> 8 << 8) | (getOpacity()), 6);
 			buildImageArray(0, 0, points, texs);
+
+			if(mTexture->isAtlased())
+			{
+				for(int i = 0; i < 12; i += 2)
+				{
+					Eigen::Vector2f tex = mTexture->getTexCoord(texs[i], texs[i + 1]);
+					texs[i] = tex.x();
+					texs[i + 1] = tex.y();
+				}
+			}
 		}
 
 		drawImageArray(points, texs, colors, 6);
@@ -232,6 +284,7 @@ bool ImageComponent::hasImage()
 
 void ImageComponent::copyScreen()
 {
+	mPath = "";
 	mTexture.reset();
 
 	mTexture = TextureResource::get("");
@@ -36,6 +36,7 @@ public:
 
 	bool hasImage();
 
+	void update(int deltaTime) override;
 	void render(const Eigen::Affine3f& parentTrans) override;
 
 private:
@@ -44,7 +45,11 @@ private:
 
 	bool mAllowUpscale, mTiled, mFlipX, mFlipY;
 
+	Eigen::Vector2i mResizedTextureSize; //the texture size the last resize() saw, textures load in the background
+
 	void resize();
+	Eigen::Vector2i getLoadSize() const; //the size the texture is asked for, so it isn't decoded any bigger than it's drawn
+	void requestTexture();
 	void buildImageArray(int x, int y, GLfloat* points, GLfloat* texs, float percentageX = 1, float percentageY = 1); //writes 12 GLfloat points and 12 GLfloat texture coordinates to a given array at a given position
 	void drawImageArray(GLfloat* points, GLfloat* texs, GLubyte* colors, unsigned int count = 6); //draws the given set of points and texture coordinates, number of coordinate pairs may be specified (default 6)
 
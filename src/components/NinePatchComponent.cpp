@@ -26,7 +26,8 @@ void NinePatchComponent::buildVertices()
 	if(mColors != NULL)
 		delete[] mColors;
 
-	mTexture = TextureResource::get(mPath);
+	//the geometry depends on the texture size, so it can't wait for a background load
+	mTexture = TextureResource::get(mPath, false);
 
 	if(mTexture->getSize() == Eigen::Vector2i::Zero())
 	{
@@ -140,9 +141,23 @@ void NinePatchComponent::render(const Eigen::Affine3f& parentTrans)
 		glEnableClientState(GL_COLOR_ARRAY);
 
 		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].tex);
 		glColorPointer(4, GL_UNSIGNED_BYTE, 0, mColors);
 
+		//mapped here and not in buildVertices(), the texture may have moved within the atlas since
+		GLfloat atlasTexs[6 * 9 * 2];
+		if(mTexture->isAtlased())
+		{
+			for(int i = 0; i < 6 * 9; i++)
+			{
+				Eigen::Vector2f tex = mTexture->getTexCoord(mVertices[i].tex.x(), mVertices[i].tex.y());
+				atlasTexs[i * 2] = tex.x();
+				atlasTexs[i * 2 + 1] = tex.y();
+			}
+			glTexCoordPointer(2, GL_FLOAT, 0, atlasTexs);
+		}else{
+			glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].tex);
+		}
+
 		glDrawArrays(GL_TRIANGLES, 0, 6 * 9);
 
 		glDisableClientState(GL_VERTEX_ARRAY);
@@ -1,11 +1,12 @@
 #include "RatingComponent.h"
 #include "../Renderer.h"
 #include "../Window.h"
+#include <algorithm>
 
 RatingComponent::RatingComponent(Window* window) : GuiComponent(window)
 {
-	mFilledTexture = TextureResource::get(":/star_filled.png");
-	mUnfilledTexture = TextureResource::get(":/star_unfilled.png");
+	mFilledTexture = TextureResource::get(":/star_filled.png", false);
+	mUnfilledTexture = TextureResource::get(":/star_unfilled.png", false);
 	mValue = 0.5f;
 	mSize << 64 * 5.0f, 64;
 	updateVertices();
@@ -37,35 +38,35 @@ void RatingComponent::onSizeChanged()
 	updateVertices();
 }
 
-void RatingComponent::updateVertices()
+void RatingComponent::setQuad(Vertex* vertices, float left, float right, float height, float texLeft, float texRight)
 {
-	const float numStars = 5.0f;
+	vertices[0].pos << left, 0.0f;
+		vertices[0].tex << texLeft, 1.0f;
+	vertices[1].pos << right, height;
+		vertices[1].tex << texRight, 0.0f;
+	vertices[2].pos << left, height;
+		vertices[2].tex << texLeft, 0.0f;
+
+	vertices[3] = vertices[0];
+	vertices[4].pos << right, 0.0f;
+		vertices[4].tex << texRight, 1.0f;
+	vertices[5] = vertices[1];
+}
 
+void RatingComponent::updateVertices()
+{
 	const float h = getSize().y();
-	const float w = h * mValue * numStars;
-	const float fw = h * numStars;
-
-	mVertices[0].pos << 0.0f, 0.0f;
-		mVertices[0].tex << 0.0f, 1.0f;
-	mVertices[1].pos << w, h;
-		mVertices[1].tex << mValue * numStars, 0.0f;
-	mVertices[2].pos << 0.0f, h;
-		mVertices[2].tex << 0.0f, 0.0f;
-
-	mVertices[3] = mVertices[0];
-	mVertices[4].pos << w, 0.0f;
-		mVertices[4].tex << mValue * numStars, 1.0f;
-	mVertices[5] = mVertices[1];
-
-	mVertices[6] = mVertices[4];
-	mVertices[7].pos << fw, h;
-		mVertices[7].tex << numStars, 0.0f;
-	mVertices[8] = mVertices[1];
-
-	mVertices[9] = mVertices[6];
-	mVertices[10].pos << fw, 0.0f;
-		mVertices[10].tex << numStars, 1.0f;
-	mVertices[11] = mVertices[7];
+	const float stars = mValue * NUM_STARS;
+
+	for(int i = 0; i < NUM_STARS; i++)
+	{
+		//how much of this star is filled, 0 to 1
+		const float filled = std::min(std::max(stars - i, 0.0f), 1.0f);
+		const float x = h * i;
+
+		setQuad(&mVertices[i * 6], x, x + h * filled, h, 0.0f, filled);
+		setQuad(&mVertices[(NUM_STARS + i) * 6], x + h * filled, x + h, h, filled, 1.0f);
+	}
 }
 
 void RatingComponent::render(const Eigen::Affine3f& parentTrans)
@@ -80,14 +81,27 @@ void RatingComponent::render(const Eigen::Affine3f& parentTrans)
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	
+	const int vertexCount = NUM_STARS * 6;
+
+	//mapped to where the stars are in their texture
+	GLfloat texs[vertexCount * 2 * 2];
+	for(int i = 0; i < vertexCount * 2; i++)
+	{
+		const std::shared_ptr<TextureResource>& texture = (i < vertexCount) ? mFilledTexture : mUnfilledTexture;
+		Eigen::Vector2f tex = texture->getTexCoord(mVertices[i].tex.x(), mVertices[i].tex.y());
+		texs[i * 2] = tex.x();
+		texs[i * 2 + 1] = tex.y();
+	}
+
 	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].pos);
-	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].tex);
+	glTexCoordPointer(2, GL_FLOAT, 0, texs);
 	
+	//both are usually on the same atlas page, then the second bind is free
 	mFilledTexture->bind();
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
 
 	mUnfilledTexture->bind();
-	glDrawArrays(GL_TRIANGLES, 6, 6);
+	glDrawArrays(GL_TRIANGLES, vertexCount, vertexCount);
 
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -16,15 +16,21 @@ public:
 
 	void onSizeChanged() override;
 private:
+	static const int NUM_STARS = 5;
+
 	void updateVertices();
 
 	float mValue;
 
+	//a quad for the filled part of every star, then one for the unfilled part of every star - the stars can't be drawn
+	//as one repeating texture, they may share theirs with other images (see TextureAtlas)
 	struct Vertex
 	{
 		Eigen::Vector2f pos;
 		Eigen::Vector2f tex;
-	} mVertices[12];
+	} mVertices[NUM_STARS * 2 * 6];
+
+	static void setQuad(Vertex* vertices, float left, float right, float height, float texLeft, float texRight);
 
 	std::shared_ptr<TextureResource> mFilledTexture;
 	std::shared_ptr<TextureResource> mUnfilledTexture;
@@ -104,8 +104,21 @@ void VerticalImageAutoScrollbox::render(const Eigen::Affine3f& parentTrans)
 }
 
 
+void VerticalImageAutoScrollbox::restack()
+{
+        for (unsigned int i=1; i<getChildCount(); ++i)
+        {
+                GuiComponent *prev = getChild(i-1);
+                GuiComponent *img = getChild(i);
+                float posY = prev->getPosition().y() + prev->getSize().y() + mBorderSpace;
+                if (img->getPosition().y() != posY)
+                        img->setPosition(img->getPosition().x(), posY);
+        }
+}
+
 void VerticalImageAutoScrollbox::update(int deltaTime)
 {
+        restack();
         mAutoScrollTimer += deltaTime;
         if (mAutoScrollTimer > mAutoScrollDelay)
         {
@@ -19,6 +19,7 @@ public:
         void setAllowImageUpscale(bool allowUpscaling);
 
         // positions image behind current last image and does an addChild
+        // call it before img->setImage(), so the image is loaded at the width it's shown with
         void addImage(ImageComponent *img);
 
 	void update(int deltaTime) override;
@@ -26,6 +27,8 @@ public:
 
 private:
         float getAnimTargetPos(unsigned int childNo) const;
+        // moves the images so they line up again after one of them changed its size (images load in the background)
+        void restack();
 
 	Eigen::Vector2f getContentSize() const;
 
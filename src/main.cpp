@@ -16,11 +16,16 @@
 #include "EmulationStation.h"
 #include "Settings.h"
 #include "ScraperCmdLine.h"
+#include "GamelistWriter.h"
+#include "resources/TextureLoader.h"
+#include "ImageIO.h"
 #include <sstream>
 
 namespace fs = boost::filesystem;
 
 bool scrape_cmdline = false;
+bool benchmark_images = false;
+bool build_thumbnails = false;
 
 bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height)
 {
@@ -56,12 +61,25 @@ bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height
 			{
 				Settings::getInstance()->setInt("DIMTIME", atoi(argv[i + 1]) * 1000);
 				i++; //skip the argument value
+			}else if(strcmp(argv[i], "--load-threads") == 0)
+			{
+				Settings::getInstance()->setInt("LoadThreads", atoi(argv[i + 1]));
+				i++; //skip the argument value
+			}else if(strcmp(argv[i], "--rescan") == 0)
+			{
+				Settings::getInstance()->setBool("ForceRescan", true);
 			}else if(strcmp(argv[i], "--windowed") == 0)
 			{
 				Settings::getInstance()->setBool("WINDOWED", true);
 			}else if(strcmp(argv[i], "--scrape") == 0)
 			{
 				scrape_cmdline = true;
+			}else if(strcmp(argv[i], "--build-thumbnails") == 0)
+			{
+				build_thumbnails = true;
+			}else if(strcmp(argv[i], "--benchmark-images") == 0)
+			{
+				benchmark_images = true;
 			}else if(strcmp(argv[i], "--help") == 0)
 			{
 				std::cout << "EmulationStation, a graphical front-end for ROM browsing.\n";
@@ -74,8 +92,12 @@ bool parseArgs(int argc, char* argv[], unsigned int* width, unsigned int* height
 				std::cout << "--no-exit			don't show the exit option in the menu\n";
 				std::cout << "--debug				even more logging\n";
 				std::cout << "--dimtime [seconds]		time to wait before dimming the screen (default 30, use 0 for never)\n";
+				std::cout << "--load-threads [count]		number of systems to load in parallel (default 0, one per CPU core)\n";
+				std::cout << "--rescan			ignore the scan cache and read every ROM directory again\n";
 				std::cout << "--scrape			scrape using command line interface\n";
 				std::cout << "--windowed			not fullscreen\n";
+				std::cout << "--build-thumbnails		decode every game image into the thumbnail cache and exit\n";
+				std::cout << "--benchmark-images		time the image pixel conversion and exit\n";
 				std::cout << "--help				summon a sentient, angry tuba\n\n";
 				std::cout << "More information available in README.md.\n";
 				return false; //exit after printing help
@@ -119,6 +141,12 @@ int main(int argc, char* argv[])
 	if(!parseArgs(argc, argv, &width, &height))
 		return 0;
 
+	if(benchmark_images)
+	{
+		ImageIO::benchmark();
+		return 0;
+	}
+
 	//if ~/.emulationstation doesn't exist and cannot be created, bail
 	if(!verifyHomeFolderExists())
 		return 1;
@@ -157,6 +185,20 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
+	//fill the thumbnail cache then quit - the image sizes depend on the themes, so this needs the window
+	if(build_thumbnails)
+	{
+		GuiGameList* list = new GuiGameList(&window);
+		std::cout << list->buildThumbnails() << " images added to the thumbnail cache\n";
+		delete list;
+
+		window.deinit();
+		TextureLoader::getInstance()->stop();
+		SystemData::deleteSystems();
+		GamelistWriter::getInstance()->stop();
+		return 0;
+	}
+
 	//dont generate joystick events while we're loading (hopefully fixes "automatically started emulator" bug)
 	SDL_JoystickEventState(SDL_DISABLE);
 
@@ -240,7 +282,9 @@ int main(int argc, char* argv[])
 	}
 
 	window.deinit();
+	TextureLoader::getInstance()->stop();
 	SystemData::deleteSystems();
+	GamelistWriter::getInstance()->stop();
 
 	std::cout << "EmulationStation cleanly shutting down...\n";
 
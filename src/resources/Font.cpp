@@ -135,7 +135,7 @@ void Font::deinit()
 {
 	if(textureID)
 	{
-		glDeleteTextures(1, &textureID);
+		Renderer::deleteTexture(textureID);
 		textureID = 0;
 	}
 }
@@ -177,7 +177,7 @@ void Font::buildAtlas(ResourceData data)
 
 	//create the texture
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	Renderer::bindTexture(textureID);
 
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -242,7 +242,7 @@ void Font::buildAtlas(ResourceData data)
 		x += g->bitmap.width + 1; //leave one pixel of space between glyphs
 	}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	Renderer::bindTexture(0);
 
 	FT_Done_Face(face);
 
@@ -280,7 +280,7 @@ void Font::renderTextCache(TextCache* cache)
 		return;
 	}
 
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	Renderer::bindTexture(textureID);
 	glEnable(GL_TEXTURE_2D);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
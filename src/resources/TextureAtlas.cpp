@@ -0,0 +1,176 @@
+#include "TextureAtlas.h"
+#include "../Renderer.h"
+#include "../Settings.h"
+#include "../Log.h"
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+	//every image gets a border of copies of its edge pixels, so filtering never picks up its neighbours
+	const size_t PADDING = 1;
+}
+
+TextureAtlas* TextureAtlas::sInstance = NULL;
+
+TextureAtlas* TextureAtlas::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new TextureAtlas();
+
+	return sInstance;
+}
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+bool TextureAtlas::fits(size_t width, size_t height)
+{
+	const int maxSize = Settings::getInstance()->getInt("TextureAtlasMaxSize");
+	if(maxSize <= 0)
+		return false;
+
+	const size_t limit = std::min((size_t)maxSize, PAGE_SIZE - PADDING * 2);
+	return width > 0 && height > 0 && width <= limit && height <= limit;
+}
+
+bool TextureAtlas::allocate(Page& page, size_t width, size_t height, size_t& x, size_t& y)
+{
+	//next to the last image on the current shelf...
+	if(page.shelfX + width <= PAGE_SIZE && page.shelfY + std::max(page.shelfHeight, height) <= PAGE_SIZE)
+	{
+		x = page.shelfX;
+		y = page.shelfY;
+		page.shelfX += width;
+		page.shelfHeight = std::max(page.shelfHeight, height);
+		return true;
+	}
+
+	//...or at the start of a new one
+	const size_t nextShelfY = page.shelfY + page.shelfHeight;
+	if(width <= PAGE_SIZE && nextShelfY + height <= PAGE_SIZE)
+	{
+		x = 0;
+		y = nextShelfY;
+		page.shelfX = width;
+		page.shelfY = nextShelfY;
+		page.shelfHeight = height;
+		return true;
+	}
+
+	return false;
+}
+
+unsigned int TextureAtlas::createPage()
+{
+	Page page = { 0, 0, 0, 0, 0 };
+	glGenTextures(1, &page.textureID);
+	Renderer::bindTexture(page.textureID);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PAGE_SIZE, PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	for(unsigned int i = 0; i < mPages.size(); i++)
+	{
+		if(mPages[i].textureID == 0)
+		{
+			mPages[i] = page;
+			return i;
+		}
+	}
+
+	mPages.push_back(page);
+	return mPages.size() - 1;
+}
+
+bool TextureAtlas::add(const unsigned char* imageRGBA, size_t width, size_t height, Region& region)
+{
+	region.textureID = 0;
+	if(!fits(width, height))
+		return false;
+
+	const size_t paddedWidth = width + PADDING * 2;
+	const size_t paddedHeight = height + PADDING * 2;
+
+	size_t x = 0, y = 0;
+	unsigned int pageIndex = 0;
+	for(; pageIndex < mPages.size(); pageIndex++)
+	{
+		if(mPages[pageIndex].textureID != 0 && allocate(mPages[pageIndex], paddedWidth, paddedHeight, x, y))
+			break;
+	}
+
+	if(pageIndex == mPages.size())
+	{
+		pageIndex = createPage();
+		if(!allocate(mPages[pageIndex], paddedWidth, paddedHeight, x, y))
+			return false;
+	}
+
+	Page& page = mPages[pageIndex];
+
+	//the image with its border, a line at a time
+	std::vector<unsigned char> padded(paddedWidth * paddedHeight * 4);
+	for(size_t line = 0; line < paddedHeight; line++)
+	{
+		const size_t sourceLine = std::min(std::max(line, PADDING) - PADDING, height - 1);
+		const unsigned char* src = imageRGBA + sourceLine * width * 4;
+		unsigned char* dest = &padded[line * paddedWidth * 4];
+
+		for(size_t i = 0; i < PADDING; i++)
+		{
+			memcpy(dest + i * 4, src, 4);
+			memcpy(dest + (PADDING + width + i) * 4, src + (width - 1) * 4, 4);
+		}
+		memcpy(dest + PADDING * 4, src, width * 4);
+	}
+
+	Renderer::bindTexture(page.textureID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+
+	page.images++;
+
+	region.textureID = page.textureID;
+	region.page = pageIndex;
+	region.texOrigin << (float)(x + PADDING) / PAGE_SIZE, (float)(y + PADDING) / PAGE_SIZE;
+	region.texSize << (float)width / PAGE_SIZE, (float)height / PAGE_SIZE;
+	return true;
+}
+
+void TextureAtlas::remove(Region& region)
+{
+	if(region.textureID == 0 || region.page >= mPages.size() || mPages[region.page].textureID != region.textureID)
+		return;
+
+	Page& page = mPages[region.page];
+	if(--page.images == 0)
+	{
+		Renderer::deleteTexture(page.textureID);
+		page.textureID = 0;
+	}
+
+	region.textureID = 0;
+}
+
+size_t TextureAtlas::getBytes() const
+{
+	return getPageCount() * PAGE_SIZE * PAGE_SIZE * 4;
+}
+
+unsigned int TextureAtlas::getPageCount() const
+{
+	unsigned int count = 0;
+	for(auto it = mPages.begin(); it != mPages.end(); it++)
+	{
+		if(it->textureID != 0)
+			count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+#include "../platform.h"
+#include GLHEADER
+
+//Packs small images (UI art, icons) into a few shared textures, so drawing them doesn't switch textures
+//all the time - draws from the same page can even share one draw call.
+//Images no bigger than the "TextureAtlasMaxSize" setting (in pixels per side, 0 = off) go into pages of PAGE_SIZE x
+//PAGE_SIZE pixels, on shelves. Space isn't reused while a page still has images; once it's empty, it is deleted.
+//Images can't repeat inside a page, so nothing that's drawn tiled belongs in here. Main thread only.
+class TextureAtlas
+{
+public:
+	static const size_t PAGE_SIZE = 512;
+
+	struct Region
+	{
+		GLuint textureID; //of the page, 0 if the image isn't in the atlas
+		unsigned int page;
+		Eigen::Vector2f texOrigin; //texture coordinates of the image within the page
+		Eigen::Vector2f texSize;
+	};
+
+	static TextureAtlas* getInstance();
+
+	//True if an image of width x height is small enough for the atlas. Safe to call from any thread.
+	static bool fits(size_t width, size_t height);
+
+	//Copies an RGBA image into a page. Returns false (region.textureID is 0) if it doesn't fit.
+	bool add(const unsigned char* imageRGBA, size_t width, size_t height, Region& region);
+	void remove(Region& region);
+
+	unsigned int getPageCount() const;
+	size_t getBytes() const; //of every page, however full it is
+
+private:
+	TextureAtlas();
+
+	struct Page
+	{
+		GLuint textureID; //0 for a page that was deleted, its slot is reused
+		size_t shelfX; //where the next image on the current shelf goes
+		size_t shelfY;
+		size_t shelfHeight;
+		unsigned int images;
+	};
+
+	//finds room for a width x height block (padding included) on page, returns false if there is none
+	static bool allocate(Page& page, size_t width, size_t height, size_t& x, size_t& y);
+	unsigned int createPage();
+
+	static TextureAtlas* sInstance;
+
+	std::vector<Page> mPages;
+};
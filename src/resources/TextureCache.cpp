@@ -0,0 +1,101 @@
+#include "TextureCache.h"
+#include "TextureResource.h"
+#include "TextureAtlas.h"
+#include "../Settings.h"
+
+TextureCache* TextureCache::sInstance = NULL;
+
+TextureCache* TextureCache::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new TextureCache();
+
+	return sInstance;
+}
+
+TextureCache::TextureCache()
+{
+	Stats stats = { 0, 0, 0, 0, 0, 0 };
+	mStats = stats;
+}
+
+std::shared_ptr<TextureResource> TextureCache::get(const std::string& path)
+{
+	auto found = mIndex.find(path);
+	if(found == mIndex.end())
+	{
+		mStats.misses++;
+		return NULL;
+	}
+
+	mStats.hits++;
+	mEntries.splice(mEntries.begin(), mEntries, found->second);
+	return found->second->texture;
+}
+
+void TextureCache::add(const std::string& path, const std::shared_ptr<TextureResource>& texture)
+{
+	Entry entry = { path, texture, 0, 0 };
+	mEntries.push_front(entry);
+	mIndex[path] = mEntries.begin();
+	mStats.textures++;
+}
+
+void TextureCache::setBytes(const std::string& path, size_t bytes, size_t rgbaBytes)
+{
+	auto found = mIndex.find(path);
+	if(found == mIndex.end())
+		return;
+
+	Entry& entry = *found->second;
+	mStats.residentBytes = mStats.residentBytes - entry.bytes + bytes;
+	bool grew = bytes > entry.bytes;
+	entry.bytes = bytes;
+	mStats.savedBytes = mStats.savedBytes - entry.savedBytes + (rgbaBytes - bytes);
+	entry.savedBytes = rgbaBytes - bytes;
+
+	if(grew)
+	{
+		int budget = Settings::getInstance()->getInt("TextureCacheSize");
+		trim(budget > 0 ? (size_t)budget * 1024 * 1024 : 0);
+	}
+}
+
+void TextureCache::purge()
+{
+	trim(0);
+}
+
+void TextureCache::trim(size_t maxBytes)
+{
+	auto it = mEntries.end();
+	while((maxBytes == 0 || getResidentBytes() > maxBytes) && it != mEntries.begin())
+	{
+		it--;
+
+		//the cache holds the only reference, nobody is going to miss it
+		if(it->texture.use_count() != 1)
+			continue;
+
+		//take the texture out first - deleting it calls setBytes() for its path
+		std::shared_ptr<TextureResource> texture = it->texture;
+		mStats.residentBytes -= it->bytes;
+		mStats.savedBytes -= it->savedBytes;
+		mStats.textures--;
+		mStats.evictions++;
+		mIndex.erase(it->path);
+		it = mEntries.erase(it);
+	}
+}
+
+size_t TextureCache::getResidentBytes() const
+{
+	return mStats.residentBytes + TextureAtlas::getInstance()->getBytes();
+}
+
+TextureCache::Stats TextureCache::getStats() const
+{
+	Stats stats = mStats;
+	stats.residentBytes = getResidentBytes();
+	return stats;
+}
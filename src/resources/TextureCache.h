@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+class TextureResource;
+
+//Keeps every texture loaded from a path, so asking for the same image again (like scrolling back to a game) reuses it
+//instead of reading and decoding the file again.
+//Textures nobody else holds on to stay around until the textures in the cache take up more than the "TextureCacheSize"
+//setting (in MB); then the least recently used of them are freed. Textures still in use are never freed, but count
+//towards the budget - so do the TextureAtlas pages, whole, in place of the images in them.
+class TextureCache
+{
+public:
+	struct Stats
+	{
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int evictions;
+		unsigned int textures;
+		size_t residentBytes; //of every texture in the cache, used or not, and of the TextureAtlas pages
+		size_t savedBytes; //how much more they'd take up with 32 bits per pixel
+	};
+
+	static TextureCache* getInstance();
+
+	//Returns the texture loaded from path and marks it as used most recently, or NULL if it isn't cached.
+	std::shared_ptr<TextureResource> get(const std::string& path);
+	void add(const std::string& path, const std::shared_ptr<TextureResource>& texture);
+
+	//Called by the texture of path whenever its video memory size changed. rgbaBytes is the size it'd have with 32 bits
+	//per pixel.
+	void setBytes(const std::string& path, size_t bytes, size_t rgbaBytes);
+
+	//Frees every texture nobody else holds on to, e.g. before the GL context goes away - they'd have to be decoded
+	//again anyway.
+	void purge();
+
+	Stats getStats() const;
+
+private:
+	TextureCache();
+
+	struct Entry
+	{
+		std::string path;
+		std::shared_ptr<TextureResource> texture;
+		size_t bytes;
+		size_t savedBytes;
+	};
+
+	//frees unused textures, least recently used first, until at most maxBytes are resident (0 = all of them)
+	void trim(size_t maxBytes);
+	size_t getResidentBytes() const; //with the atlas pages
+
+	static TextureCache* sInstance;
+
+	std::list<Entry> mEntries; //most recently used first
+	std::unordered_map< std::string, std::list<Entry>::iterator > mIndex; //path -> entry
+	Stats mStats;
+};
@@ -0,0 +1,255 @@
+#include "TextureLoader.h"
+#include "TextureResource.h"
+#include "ResourceManager.h"
+#include "../ImageIO.h"
+#include "../Settings.h"
+#include <chrono>
+
+namespace
+{
+	//weak_ptrs can't be compared directly, and must not be lock()ed on the worker threads
+	bool isSameTexture(const std::weak_ptr<TextureResource>& a, const std::shared_ptr<TextureResource>& b)
+	{
+		return !a.owner_before(b) && !b.owner_before(a);
+	}
+}
+
+TextureLoader* TextureLoader::sInstance = NULL;
+
+TextureLoader* TextureLoader::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new TextureLoader();
+
+	return sInstance;
+}
+
+TextureLoader::TextureLoader() : mRunning(false)
+{
+}
+
+void TextureLoader::queue(const std::shared_ptr<TextureResource>& texture, const std::string& path, unsigned int loadId,
+	size_t targetWidth, size_t targetHeight, bool prefetch)
+{
+	std::lock_guard<std::mutex> lock(mJobMutex);
+
+	Job job = { texture, path, loadId, targetWidth, targetHeight, prefetch };
+	if(prefetch)
+		mPrefetchJobs.push_back(job);
+	else
+		mJobs.push_back(job);
+
+	if(!mRunning)
+	{
+		mRunning = true;
+
+		int setting = Settings::getInstance()->getInt("TextureLoadThreads");
+		unsigned int count = setting > 0 ? (unsigned int)setting : std::thread::hardware_concurrency();
+		if(count == 0)
+			count = 1;
+
+		for(unsigned int i = 0; i < count; i++)
+			mThreads.push_back(std::thread(&TextureLoader::run, this));
+	}
+
+	mJobCondition.notify_one();
+}
+
+void TextureLoader::promote(const std::shared_ptr<TextureResource>& texture)
+{
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		for(auto it = mPrefetchJobs.begin(); it != mPrefetchJobs.end(); it++)
+		{
+			if(isSameTexture(it->texture, texture))
+			{
+				Job job = *it;
+				job.prefetch = false;
+				mPrefetchJobs.erase(it);
+				mJobs.push_back(job);
+				return;
+			}
+		}
+	}
+
+	//already decoded (or being decoded right now, then it ends up in the wrong queue - it's still uploaded eventually)
+	std::lock_guard<std::mutex> lock(mDecodedMutex);
+	for(auto it = mPrefetchDecoded.begin(); it != mPrefetchDecoded.end(); it++)
+	{
+		if(isSameTexture(it->texture, texture))
+		{
+			mDecoded.push_back(std::move(*it));
+			mPrefetchDecoded.erase(it);
+			return;
+		}
+	}
+}
+
+void TextureLoader::cancelPrefetches()
+{
+	std::deque<Job> cancelled;
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		cancelled.swap(mPrefetchJobs);
+	}
+
+	for(auto it = cancelled.begin(); it != cancelled.end(); it++)
+	{
+		std::shared_ptr<TextureResource> texture = it->texture.lock();
+		if(texture)
+			texture->cancelLoad(it->loadId);
+	}
+}
+
+bool TextureLoader::takeJob(Job& job)
+{
+	//the image asked for last is usually the one on screen, older ones were likely scrolled past
+	if(!mJobs.empty())
+	{
+		job = mJobs.back();
+		mJobs.pop_back();
+		return true;
+	}
+
+	if(!mPrefetchJobs.empty())
+	{
+		job = mPrefetchJobs.front();
+		mPrefetchJobs.pop_front();
+		return true;
+	}
+
+	return false;
+}
+
+void TextureLoader::run()
+{
+	std::unique_lock<std::mutex> lock(mJobMutex);
+	while(mRunning)
+	{
+		Job job;
+		if(!takeJob(job))
+		{
+			mJobCondition.wait(lock);
+			continue;
+		}
+
+		//only ever check, never lock() - if this thread held the last reference, the texture would be deleted without a GL context
+		if(job.texture.expired())
+			continue;
+
+		lock.unlock();
+
+		Decoded decoded = { job.texture, job.loadId, std::vector<unsigned char>(), NULL, ImageIO::PIXEL_RGBA8888, 0, 0, 0, 0 };
+
+		//only images that are scaled down end up in the thumbnail cache
+		const bool scaled = job.targetWidth != 0 || job.targetHeight != 0;
+		if(scaled)
+			decoded.thumbnail = ThumbnailCache::getInstance()->get(job.path, job.targetWidth, job.targetHeight);
+
+		if(decoded.thumbnail)
+		{
+			decoded.format = decoded.thumbnail->getFormat();
+			decoded.width = decoded.thumbnail->getWidth();
+			decoded.height = decoded.thumbnail->getHeight();
+			decoded.sourceWidth = decoded.thumbnail->getSourceWidth();
+			decoded.sourceHeight = decoded.thumbnail->getSourceHeight();
+		}else{
+			const ResourceData data = ResourceManager::getInstance()->getFileData(job.path);
+			if(data.ptr && ImageIO::loadFromMemoryRGBA32(data.ptr.get(), data.length, job.targetWidth, job.targetHeight,
+				decoded.image, decoded.width, decoded.height, decoded.sourceWidth, decoded.sourceHeight))
+			{
+				decoded.format = TextureResource::packForUpload(decoded.image, decoded.width, decoded.height);
+				if(scaled)
+				{
+					ThumbnailCache::getInstance()->put(job.path, job.targetWidth, job.targetHeight, decoded.image.data(), decoded.format,
+						decoded.width, decoded.height, decoded.sourceWidth, decoded.sourceHeight);
+				}
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> decodedLock(mDecodedMutex);
+			if(job.prefetch)
+				mPrefetchDecoded.push_back(std::move(decoded));
+			else
+				mDecoded.push_back(std::move(decoded));
+		}
+
+		lock.lock();
+	}
+}
+
+bool TextureLoader::takeDecoded(std::deque<Decoded>& queue, Decoded& decoded)
+{
+	std::lock_guard<std::mutex> lock(mDecodedMutex);
+	if(queue.empty())
+		return false;
+
+	decoded = std::move(queue.front());
+	queue.pop_front();
+	return true;
+}
+
+void TextureLoader::upload(const Decoded& decoded)
+{
+	std::shared_ptr<TextureResource> texture = decoded.texture.lock();
+	if(!texture)
+		return;
+
+	const unsigned char* pixels = NULL;
+	if(decoded.thumbnail)
+		pixels = decoded.thumbnail->getPixels();
+	else if(!decoded.image.empty())
+		pixels = decoded.image.data();
+
+	texture->finishLoad(decoded.loadId, pixels, decoded.format, decoded.width, decoded.height, decoded.sourceWidth, decoded.sourceHeight);
+}
+
+void TextureLoader::uploadPending()
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::time_point start = Clock::now();
+	const std::chrono::milliseconds budget(Settings::getInstance()->getInt("TextureUploadTime"));
+
+	//visible images first, at least one per frame...
+	Decoded decoded;
+	bool first = true;
+	while((first || Clock::now() - start < budget) && takeDecoded(mDecoded, decoded))
+	{
+		first = false;
+		upload(decoded);
+	}
+
+	//...prefetches only with the time that's left
+	while(Clock::now() - start < budget && takeDecoded(mPrefetchDecoded, decoded))
+		upload(decoded);
+}
+
+void TextureLoader::clear()
+{
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		mJobs.clear();
+		mPrefetchJobs.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(mDecodedMutex);
+	mDecoded.clear();
+	mPrefetchDecoded.clear();
+}
+
+void TextureLoader::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mJobMutex);
+		mRunning = false;
+		mJobCondition.notify_all();
+	}
+
+	for(auto it = mThreads.begin(); it != mThreads.end(); it++)
+		it->join();
+	mThreads.clear();
+
+	clear();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "ThumbnailCache.h"
+
+class TextureResource;
+
+//Reads and decodes image files on worker threads, so asking for a texture never blocks the frame that asked.
+//Decoded images wait in a queue until uploadPending() turns them into OpenGL textures on the main thread (the only one
+//with a GL context) - a few per frame, as many as fit into the "TextureUploadTime" setting.
+//Prefetches (images nobody shows yet) have their own, lower priority queues: they're only decoded while no visible
+//image waits, and only uploaded with what is left of the frame's time budget.
+//Images scaled down on the way are kept in the ThumbnailCache, later loads of them skip decoding altogether.
+class TextureLoader
+{
+public:
+	static TextureLoader* getInstance();
+
+	//Decodes path on a worker thread and hands the result to texture with a later uploadPending(), unless texture is gone
+	//or started another load (loadId changed) by then. The image is scaled down to targetWidth x targetHeight on the way
+	//(see ImageIO::loadFromMemoryRGBA32()). Main thread only.
+	void queue(const std::shared_ptr<TextureResource>& texture, const std::string& path, unsigned int loadId,
+		size_t targetWidth, size_t targetHeight, bool prefetch = false);
+
+	//Moves the prefetch of texture up to the visible queues, it's needed on screen now. Main thread only.
+	void promote(const std::shared_ptr<TextureResource>& texture);
+
+	//Drops every prefetch that isn't being decoded yet; their textures are left unloaded. Main thread only.
+	void cancelPrefetches();
+
+	//Uploads decoded images until this frame's time budget is used up, at least one. Main thread only.
+	void uploadPending();
+
+	//Forgets every queued and decoded image, e.g. before the GL context goes away.
+	void clear();
+
+	//Clears and stops the worker threads (they're started again by the next queue()).
+	void stop();
+
+private:
+	TextureLoader();
+
+	struct Job
+	{
+		std::weak_ptr<TextureResource> texture;
+		std::string path;
+		unsigned int loadId;
+		size_t targetWidth;
+		size_t targetHeight;
+		bool prefetch;
+	};
+
+	struct Decoded
+	{
+		std::weak_ptr<TextureResource> texture;
+		unsigned int loadId;
+		std::vector<unsigned char> image; //packed for upload, empty if the file couldn't be read or decoded
+		std::shared_ptr<ThumbnailCache::Thumbnail> thumbnail; //has the pixels instead of image if they were cached
+		ImageIO::PixelFormat format;
+		size_t width;
+		size_t height;
+		size_t sourceWidth; //of the image in the file
+		size_t sourceHeight;
+	};
+
+	void run();
+	bool takeJob(Job& job);
+	bool takeDecoded(std::deque<Decoded>& queue, Decoded& decoded);
+	void upload(const Decoded& decoded);
+
+	static TextureLoader* sInstance;
+
+	std::vector<std::thread> mThreads;
+	bool mRunning;
+
+	std::mutex mJobMutex;
+	std::condition_variable mJobCondition;
+	std::vector<Job> mJobs; //newest last, it's the one taken next
+	std::deque<Job> mPrefetchJobs; //in the order they were asked for, closest to the cursor first
+
+	std::mutex mDecodedMutex;
+	std::deque<Decoded> mDecoded;
+	std::deque<Decoded> mPrefetchDecoded;
+};
@@ -4,13 +4,16 @@
 #include GLHEADER
 #include "../ImageIO.h"
 #include "../Renderer.h"
-
-std::map< std::string, std::weak_ptr<TextureResource> > TextureResource::sTextureMap;
-
-TextureResource::TextureResource(const std::string& path) : 
-	mTextureID(0), mPath(path), mTextureSize(Eigen::Vector2i::Zero())
+#include "TextureLoader.h"
+#include "TextureCache.h"
+#include "../Settings.h"
+
+TextureResource::TextureResource(const std::string& path, bool async) : 
+	mTextureID(0), mPath(path), mTextureSize(Eigen::Vector2i::Zero()), mAsync(async), mLoadId(0), mLoading(false),
+	mPrefetch(false), mFailed(false), mTargetSize(Eigen::Vector2i::Zero()), mLoadingTargetSize(Eigen::Vector2i::Zero()),
+	mLoadedTargetSize(Eigen::Vector2i::Zero()), mRepeat(false)
 {
-	reload(ResourceManager::getInstance());
+	mAtlasRegion.textureID = 0;
 }
 
 TextureResource::~TextureResource()
@@ -26,7 +29,97 @@ void TextureResource::unload(std::shared_ptr<ResourceManager>& rm)
 void TextureResource::reload(std::shared_ptr<ResourceManager>& rm)
 {
 	if(!mPath.empty())
-		initFromResource(rm->getFileData(mPath));
+		load();
+}
+
+void TextureResource::load(bool prefetch)
+{
+	mFailed = false;
+
+	if(mAsync)
+	{
+		//whatever is still being decoded was for an older request; a texture that's only too small keeps being shown
+		//until the bigger one arrives
+		mLoadId++;
+		mLoading = true;
+		mPrefetch = prefetch;
+		mLoadingTargetSize = mTargetSize;
+		TextureLoader::getInstance()->queue(shared_from_this(), mPath, mLoadId, mTargetSize.x(), mTargetSize.y(), prefetch);
+	}else{
+		initFromResource(ResourceManager::getInstance()->getFileData(mPath));
+		mLoadedTargetSize = Eigen::Vector2i::Zero();
+	}
+}
+
+void TextureResource::finishLoad(unsigned int loadId, const unsigned char* pixels, ImageIO::PixelFormat format, size_t width, size_t height,
+	size_t sourceWidth, size_t sourceHeight)
+{
+	if(loadId != mLoadId)
+		return;
+
+	mLoading = false;
+
+	if(pixels == NULL)
+	{
+		LOG(LogError) << "Could not initialize texture \"" << mPath << "\" (invalid resource data)!";
+		mFailed = true;
+		return;
+	}
+
+	const Eigen::Vector2i loadedTargetSize = mLoadingTargetSize;
+	deinit();
+	initFromPixels(pixels, format, width, height);
+
+	//everyone draws it at the size of the image, whatever size the texture has
+	mTextureSize << sourceWidth, sourceHeight;
+	mLoadedTargetSize = loadedTargetSize;
+}
+
+bool TextureResource::covers(const Eigen::Vector2i& have, const Eigen::Vector2i& want)
+{
+	//the image is scaled by the same factor in both directions, just enough for every nonzero side of the target size
+	//(see ImageIO::loadFromMemoryRGBA32()), so every nonzero side of want has to fit into the same side of have
+	if(have == Eigen::Vector2i::Zero())
+		return true;
+	if(want == Eigen::Vector2i::Zero())
+		return false;
+
+	return (want.x() == 0 || want.x() <= have.x()) && (want.y() == 0 || want.y() <= have.y());
+}
+
+void TextureResource::requestSize(const Eigen::Vector2i& targetSize)
+{
+	if(covers(mTargetSize, targetSize))
+		return;
+
+	if(targetSize == Eigen::Vector2i::Zero())
+		mTargetSize = Eigen::Vector2i::Zero();
+	else
+		mTargetSize = mTargetSize.cwiseMax(targetSize);
+}
+
+void TextureResource::cancelLoad(unsigned int loadId)
+{
+	if(loadId != mLoadId || !mLoading)
+		return;
+
+	mLoadId++;
+	mLoading = false;
+}
+
+bool TextureResource::needsLoad() const
+{
+	if(mFailed)
+		return false;
+
+	//what's on its way or loaded is too small for the sizes asked for since
+	if(mLoading)
+		return !covers(mLoadingTargetSize, mTargetSize);
+	if(isInitialized())
+		return !covers(mLoadedTargetSize, mTargetSize);
+
+	//neither loaded nor on its way - a prefetch that was cancelled
+	return true;
 }
 
 void TextureResource::initFromResource(const ResourceData data)
@@ -40,14 +133,77 @@ void TextureResource::initFromResource(const ResourceData data)
 	if(imageRGBA.size() == 0)
 	{
 		LOG(LogError) << "Could not initialize texture (invalid resource data)!";
+		mFailed = true;
+		return;
+	}
+
+	//the atlas pages are RGBA
+	ImageIO::PixelFormat format = usesAtlas(width, height) ? ImageIO::PIXEL_RGBA8888 : packForUpload(imageRGBA, width, height);
+	initFromPixels(imageRGBA.data(), format, width, height);
+}
+
+bool TextureResource::usesAtlas(size_t width, size_t height) const
+{
+	//game images are loaded in the background, at whatever size they're shown - and come and go all the time, while
+	//atlas space is only reused once a whole page is empty. UI art is loaded right away and kept.
+	return !mAsync && !mRepeat && !mPath.empty() && TextureAtlas::fits(width, height);
+}
+
+ImageIO::PixelFormat TextureResource::packForUpload(std::vector<unsigned char>& image, size_t width, size_t height)
+{
+	ImageIO::PixelFormat format = ImageIO::PIXEL_RGBA8888;
+	if(ImageIO::isOpaque(image.data(), width * height))
+	{
+		if(Settings::getInstance()->getBool("TexturesRGB565"))
+			format = ImageIO::PIXEL_RGB565;
+	}else if(Settings::getInstance()->getBool("TexturesRGBA4444"))
+	{
+		format = ImageIO::PIXEL_RGBA4444;
+	}
+
+	if(format != ImageIO::PIXEL_RGBA8888)
+	{
+		ImageIO::packPixels(image.data(), image.data(), width * height, format);
+		image.resize(width * height * ImageIO::getBytesPerPixel(format));
+	}
+
+	return format;
+}
+
+void TextureResource::initFromPixels(const unsigned char* pixels, ImageIO::PixelFormat format, size_t width, size_t height)
+{
+	mTextureSize << width, height;
+
+	if(usesAtlas(width, height) && format == ImageIO::PIXEL_RGBA8888 && TextureAtlas::getInstance()->add(pixels, width, height, mAtlasRegion))
+	{
+		mTextureID = mAtlasRegion.textureID;
+
+		//the cache counts the atlas pages as a whole
+		TextureCache::getInstance()->setBytes(mPath, 0, 0);
 		return;
 	}
 
 	//now for the openGL texture stuff
 	glGenTextures(1, &mTextureID);
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	Renderer::bindTexture(mTextureID);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageRGBA.data());
+	switch(format)
+	{
+	case ImageIO::PIXEL_RGB565:
+		//lines of an odd width end halfway through a 4 byte word
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		break;
+	case ImageIO::PIXEL_RGBA4444:
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, pixels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		break;
+	default:
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		break;
+	}
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -55,7 +211,8 @@ void TextureResource::initFromResource(const ResourceData data)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	mTextureSize << width, height;
+	if(!mPath.empty())
+		TextureCache::getInstance()->setBytes(mPath, width * height * ImageIO::getBytesPerPixel(format), width * height * 4);
 }
 
 void TextureResource::initFromScreen()
@@ -66,7 +223,7 @@ void TextureResource::initFromScreen()
 	int height = Renderer::getScreenHeight();
 
 	glGenTextures(1, &mTextureID);
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	Renderer::bindTexture(mTextureID);
 
 	glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 0, 0, width, height, 0);
 
@@ -93,27 +250,27 @@ void TextureResource::initFromMemory(const char* data, size_t length)
 		return;
 	}
 
-	//now for the openGL texture stuff
-	glGenTextures(1, &mTextureID);
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageRGBA.data());
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	mTextureSize << width, height;
+	ImageIO::PixelFormat format = packForUpload(imageRGBA, width, height);
+	initFromPixels(imageRGBA.data(), format, width, height);
 }
 
 void TextureResource::deinit()
 {
+	//whatever is still being decoded belongs to the old contents
+	mLoadId++;
+	mLoading = false;
+
 	if(mTextureID != 0)
 	{
-		glDeleteTextures(1, &mTextureID);
+		//the atlas page is shared, it's deleted once its last image is gone
+		if(isAtlased())
+			TextureAtlas::getInstance()->remove(mAtlasRegion);
+		else
+			Renderer::deleteTexture(mTextureID);
 		mTextureID = 0;
+
+		if(!mPath.empty())
+			TextureCache::getInstance()->setBytes(mPath, 0, 0);
 	}
 }
 
@@ -122,37 +279,106 @@ Eigen::Vector2i TextureResource::getSize() const
 	return mTextureSize;
 }
 
+bool TextureResource::isInitialized() const
+{
+	return mTextureID != 0;
+}
+
 void TextureResource::bind() const
 {
 	if(mTextureID != 0)
-		glBindTexture(GL_TEXTURE_2D, mTextureID);
-	else
+		Renderer::bindTexture(mTextureID);
+	else if(!mLoading)
 		LOG(LogError) << "Tried to bind uninitialized texture!";
 }
 
+bool TextureResource::isAtlased() const
+{
+	return mAtlasRegion.textureID != 0;
+}
+
+Eigen::Vector2f TextureResource::getTexCoord(float x, float y) const
+{
+	if(!isAtlased())
+		return Eigen::Vector2f(x, y);
+
+	return Eigen::Vector2f(mAtlasRegion.texOrigin.x() + x * mAtlasRegion.texSize.x(), mAtlasRegion.texOrigin.y() + y * mAtlasRegion.texSize.y());
+}
+
+void TextureResource::requireRepeat()
+{
+	if(mRepeat)
+		return;
+
+	mRepeat = true;
+
+	//keeps showing the atlas version (and not tiled) until the new texture arrives
+	if(isAtlased() && !mPath.empty())
+		load();
+}
+
 
-std::shared_ptr<TextureResource> TextureResource::get(const std::string& path)
+std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool async, const Eigen::Vector2i& targetSize)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 
 	if(path.empty())
 	{
-		std::shared_ptr<TextureResource> tex(new TextureResource(""));
+		std::shared_ptr<TextureResource> tex(new TextureResource("", false));
 		rm->addReloadable(tex); //make sure we're deinitialized even though we do nothing on reinitialization
 		return tex;
 	}
 
-	auto foundTexture = sTextureMap.find(path);
-	if(foundTexture != sTextureMap.end())
+	std::shared_ptr<TextureResource> tex = TextureCache::getInstance()->get(path);
+	if(tex)
 	{
-		if(!foundTexture->second.expired())
+		tex->requestSize(async ? targetSize : Eigen::Vector2i::Zero());
+
+		if(!async && (tex->mLoading || tex->needsLoad()))
+		{
+			//someone else asked for it in the background, but this caller needs it now
+			tex->mAsync = false;
+			tex->load();
+		}else if(tex->needsLoad())
+		{
+			tex->load();
+		}else if(tex->mLoading && tex->mPrefetch)
 		{
-			return foundTexture->second.lock();
+			tex->mPrefetch = false;
+			TextureLoader::getInstance()->promote(tex);
 		}
+
+		return tex;
+	}
+
+	tex = std::shared_ptr<TextureResource>(new TextureResource(path, async));
+	tex->mTargetSize = async ? targetSize : Eigen::Vector2i::Zero();
+	TextureCache::getInstance()->add(path, tex);
+	rm->addReloadable(tex);
+	tex->load();
+	return tex;
+}
+
+std::shared_ptr<TextureResource> TextureResource::prefetch(const std::string& path, const Eigen::Vector2i& targetSize)
+{
+	std::shared_ptr<TextureResource> tex = TextureCache::getInstance()->get(path);
+	if(tex)
+	{
+		tex->requestSize(targetSize);
+		if(tex->needsLoad())
+			tex->load(true);
+
+		return tex;
 	}
 
-	std::shared_ptr<TextureResource> tex = std::shared_ptr<TextureResource>(new TextureResource(path));
-	sTextureMap[path] = std::weak_ptr<TextureResource>(tex);
+	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+	if(!rm->fileExists(path))
+		return NULL;
+
+	tex = std::shared_ptr<TextureResource>(new TextureResource(path, true));
+	tex->mTargetSize = targetSize;
+	TextureCache::getInstance()->add(path, tex);
 	rm->addReloadable(tex);
+	tex->load(true);
 	return tex;
 }
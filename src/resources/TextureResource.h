@@ -1,38 +1,94 @@
 #pragma once
 
 #include "ResourceManager.h"
+#include "TextureAtlas.h"
 
 #include <string>
+#include <vector>
 #include <Eigen/Dense>
+#include "../ImageIO.h"
 #include "../platform.h"
 #include GLHEADER
 
-class TextureResource : public IReloadable
+class TextureResource : public IReloadable, public std::enable_shared_from_this<TextureResource>
 {
 public:
-	static std::shared_ptr<TextureResource> get(const std::string& path);
+	//Returns right away, with the texture from the TextureCache if path was loaded before. Otherwise, if async is true,
+	//the image is decoded by the TextureLoader and the texture stays empty (see isInitialized()) until it's uploaded,
+	//a few frames later.
+	//Asynchronous loads only decode as many pixels as drawing the image at targetSize needs (0 = any size, in both the
+	//full image). If the cached texture was loaded for a smaller size, it's loaded again - and keeps showing the small
+	//version until then.
+	static std::shared_ptr<TextureResource> get(const std::string& path, bool async = true, const Eigen::Vector2i& targetSize = Eigen::Vector2i::Zero());
+
+	//Loads path in the background with low priority, so a later get() finds it ready. Returns NULL if path doesn't exist;
+	//keep the texture to make sure it isn't evicted before it's used.
+	static std::shared_ptr<TextureResource> prefetch(const std::string& path, const Eigen::Vector2i& targetSize = Eigen::Vector2i::Zero());
+
+	//Packs a decoded RGBA image into the format it's uploaded with, in place: RGB565 if it's opaque and the
+	//"TexturesRGB565" setting is on, RGBA4444 if it isn't and "TexturesRGBA4444" is on, otherwise it stays as it is.
+	//Safe to call from any thread.
+	static ImageIO::PixelFormat packForUpload(std::vector<unsigned char>& image, size_t width, size_t height);
 
 	virtual ~TextureResource();
 
 	void unload(std::shared_ptr<ResourceManager>& rm) override;
 	void reload(std::shared_ptr<ResourceManager>& rm) override;
-	
-	Eigen::Vector2i getSize() const;
+
+	Eigen::Vector2i getSize() const; //of the image, the texture itself may have less pixels
+	bool isInitialized() const;
 	void bind() const;
-	
+
+	//Small images that aren't loaded in the background (UI art, not game images) share a texture with others (see
+	//TextureAtlas). Texture coordinates of 0 to 1 over the image have to be mapped to the image's part of it with
+	//getTexCoord().
+	bool isAtlased() const;
+	Eigen::Vector2f getTexCoord(float x, float y) const;
+
+	//Makes sure the image has a texture of its own, for users that draw it tiled (with coordinates beyond 1). An image
+	//in the atlas is loaded again.
+	void requireRepeat();
+
 	void initFromScreen();
 	void initFromMemory(const char* image, size_t length);
 
 private:
-	TextureResource(const std::string& path);
+	friend class TextureLoader;
 
-	void initFromPath();
+	TextureResource(const std::string& path, bool async);
+
+	void load(bool prefetch = false);
+	bool needsLoad() const;
+	void requestSize(const Eigen::Vector2i& targetSize);
+
+	//true if a texture loaded for target size have is good enough to be drawn at target size want
+	static bool covers(const Eigen::Vector2i& have, const Eigen::Vector2i& want);
 	void initFromResource(const ResourceData data);
+	bool usesAtlas(size_t width, size_t height) const; //true if an image of width x height goes into the TextureAtlas
+	void initFromPixels(const unsigned char* pixels, ImageIO::PixelFormat format, size_t width, size_t height);
 	void deinit();
 
+	//called by the TextureLoader with the decoded image for load loadId, pixels is NULL if it couldn't be decoded
+	void finishLoad(unsigned int loadId, const unsigned char* pixels, ImageIO::PixelFormat format, size_t width, size_t height,
+		size_t sourceWidth, size_t sourceHeight);
+	//called by the TextureLoader when it dropped the prefetch for load loadId
+	void cancelLoad(unsigned int loadId);
+
 	Eigen::Vector2i mTextureSize;
 	GLuint mTextureID;
 	const std::string mPath;
+	bool mAsync;
+
+	//bumped whenever the texture changes, so a decoded image that arrives afterwards is dropped
+	unsigned int mLoadId;
+	bool mLoading;
+	bool mPrefetch; //the load in progress is a prefetch
+	bool mFailed; //the file couldn't be read or decoded, no use trying again
+
+	Eigen::Vector2i mTargetSize; //every target size asked for so far, combined
+	Eigen::Vector2i mLoadingTargetSize; //of the load in progress
+	Eigen::Vector2i mLoadedTargetSize; //the texture was decoded for
 
-	static std::map< std::string, std::weak_ptr<TextureResource> > sTextureMap;
+	bool mRepeat; //never goes into the atlas
+	TextureAtlas::Region mAtlasRegion; //textureID is 0 if the image has a texture of its own
 };
@@ -0,0 +1,262 @@
+#include "ThumbnailCache.h"
+#include "ResourceManager.h"
+#include "TextureResource.h"
+#include "../ImageIO.h"
+#include "../Log.h"
+#include "../Settings.h"
+#include "../platform.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <sys/stat.h>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+	const char THUMBNAIL_MAGIC[4] = { 'E', 'S', 'T', 'H' };
+	const uint32_t THUMBNAIL_VERSION = 2;
+	const char THUMBNAIL_EXTENSION[] = ".thumb";
+}
+
+ThumbnailCache* ThumbnailCache::sInstance = NULL;
+
+ThumbnailCache* ThumbnailCache::getInstance()
+{
+	if(sInstance == NULL)
+		sInstance = new ThumbnailCache();
+
+	return sInstance;
+}
+
+ThumbnailCache::ThumbnailCache() : mDirectory(getHomePath() + "/.emulationstation/thumbnails"), mIndexLoaded(false),
+	mTotalBytes(0), mHits(0), mMisses(0)
+{
+}
+
+bool ThumbnailCache::isEnabled() const
+{
+	return Settings::getInstance()->getInt("ThumbnailCacheSize") > 0;
+}
+
+std::string ThumbnailCache::getKey(const std::string& path, size_t targetWidth, size_t targetHeight)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+		return "";
+
+	int64_t mtimeNsec = 0;
+#if defined(__linux__)
+	mtimeNsec = (int64_t)st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+	mtimeNsec = (int64_t)st.st_mtimespec.tv_nsec;
+#endif
+
+	return path + "|" + std::to_string((long long)st.st_size) + "|" + std::to_string((long long)st.st_mtime) + "." +
+		std::to_string((long long)mtimeNsec) + "|" + std::to_string((unsigned long long)targetWidth) + "x" +
+		std::to_string((unsigned long long)targetHeight) + "|" + (Settings::getInstance()->getBool("TexturesRGB565") ? "565" : "") +
+		(Settings::getInstance()->getBool("TexturesRGBA4444") ? "4444" : "");
+}
+
+std::string ThumbnailCache::getFileName(const std::string& key)
+{
+	//64 bit FNV-1a - the key is stored in the file too, a collision is just a miss
+	uint64_t hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < key.size(); i++)
+	{
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ULL;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+	return std::string(name) + THUMBNAIL_EXTENSION;
+}
+
+std::shared_ptr<ThumbnailCache::Thumbnail> ThumbnailCache::get(const std::string& path, size_t targetWidth, size_t targetHeight)
+{
+	if(!isEnabled())
+		return NULL;
+
+	const std::string key = getKey(path, targetWidth, targetHeight);
+	if(key.empty())
+		return NULL;
+
+	const std::string name = getFileName(key);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		loadIndex();
+		if(mIndex.find(name) == mIndex.end())
+		{
+			mMisses++;
+			return NULL;
+		}
+	}
+
+	const std::string filePath = mDirectory + "/" + name;
+	std::shared_ptr<Thumbnail> thumbnail(new Thumbnail());
+	if(!thumbnail->mFile.open(filePath))
+	{
+		mMisses++;
+		return NULL;
+	}
+
+	BinaryReader reader(thumbnail->mFile.data(), thumbnail->mFile.size());
+	reader.readMagic(THUMBNAIL_MAGIC, sizeof(THUMBNAIL_MAGIC));
+	const uint32_t version = reader.read<uint32_t>();
+	const std::string storedKey = reader.readString();
+	const uint32_t format = reader.read<uint32_t>();
+	thumbnail->mWidth = reader.read<uint32_t>();
+	thumbnail->mHeight = reader.read<uint32_t>();
+	thumbnail->mSourceWidth = reader.read<uint32_t>();
+	thumbnail->mSourceHeight = reader.read<uint32_t>();
+	thumbnail->mPixelOffset = reader.read<uint32_t>();
+
+	if(!reader.ok() || version != THUMBNAIL_VERSION || storedKey != key || format > ImageIO::PIXEL_RGBA4444)
+	{
+		mMisses++;
+		return NULL;
+	}
+
+	thumbnail->mFormat = (ImageIO::PixelFormat)format;
+	if(thumbnail->mWidth == 0 || thumbnail->mHeight == 0 || thumbnail->mPixelOffset +
+		thumbnail->mWidth * thumbnail->mHeight * ImageIO::getBytesPerPixel(thumbnail->mFormat) != thumbnail->mFile.size())
+	{
+		mMisses++;
+		return NULL;
+	}
+
+	//used just now, it's the last one to be evicted
+	const int64_t now = (int64_t)time(NULL);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto found = mIndex.find(name);
+		if(found != mIndex.end())
+			found->second.lastUse = now;
+	}
+	boost::system::error_code ec;
+	fs::last_write_time(filePath, (std::time_t)now, ec);
+
+	mHits++;
+	return thumbnail;
+}
+
+void ThumbnailCache::put(const std::string& path, size_t targetWidth, size_t targetHeight, const unsigned char* pixels, ImageIO::PixelFormat format,
+	size_t width, size_t height, size_t sourceWidth, size_t sourceHeight)
+{
+	if(!isEnabled() || width * height == 0 || (width >= sourceWidth && height >= sourceHeight))
+		return;
+
+	const std::string key = getKey(path, targetWidth, targetHeight);
+	if(key.empty())
+		return;
+
+	const std::string name = getFileName(key);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		loadIndex();
+		if(mIndex.find(name) != mIndex.end() || !mWriting.insert(name).second)
+			return;
+	}
+
+	std::string data;
+	data.append(THUMBNAIL_MAGIC, sizeof(THUMBNAIL_MAGIC));
+	writeBinaryValue<uint32_t>(data, THUMBNAIL_VERSION);
+	writeBinaryString(data, key);
+	writeBinaryValue<uint32_t>(data, (uint32_t)format);
+	writeBinaryValue<uint32_t>(data, (uint32_t)width);
+	writeBinaryValue<uint32_t>(data, (uint32_t)height);
+	writeBinaryValue<uint32_t>(data, (uint32_t)sourceWidth);
+	writeBinaryValue<uint32_t>(data, (uint32_t)sourceHeight);
+
+	//the pixels start at a multiple of 4, like the lines of a texture
+	const size_t pixelOffset = (data.size() + sizeof(uint32_t) + 3) & ~(size_t)3;
+	writeBinaryValue<uint32_t>(data, (uint32_t)pixelOffset);
+	data.resize(pixelOffset, '\0');
+	data.append((const char*)pixels, width * height * ImageIO::getBytesPerPixel(format));
+
+	const bool written = writeFileAtomically(mDirectory + "/" + name, data);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mWriting.erase(name);
+	if(written)
+	{
+		Entry entry = { data.size(), (int64_t)time(NULL) };
+		mIndex[name] = entry;
+		mTotalBytes += entry.bytes;
+		trim((uint64_t)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024);
+	}
+}
+
+bool ThumbnailCache::build(const std::string& path, size_t targetWidth, size_t targetHeight)
+{
+	if(!isEnabled())
+		return false;
+
+	if(get(path, targetWidth, targetHeight))
+		return false;
+
+	const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+	if(!data.ptr)
+		return false;
+
+	std::vector<unsigned char> image;
+	size_t width, height, sourceWidth, sourceHeight;
+	if(!ImageIO::loadFromMemoryRGBA32(data.ptr.get(), data.length, targetWidth, targetHeight, image,
+		width, height, sourceWidth, sourceHeight))
+		return false;
+
+	ImageIO::PixelFormat format = TextureResource::packForUpload(image, width, height);
+	put(path, targetWidth, targetHeight, image.data(), format, width, height, sourceWidth, sourceHeight);
+	return true;
+}
+
+void ThumbnailCache::loadIndex()
+{
+	if(mIndexLoaded)
+		return;
+
+	mIndexLoaded = true;
+
+	boost::system::error_code ec;
+	for(fs::directory_iterator it(mDirectory, ec), end; !ec && it != end; it.increment(ec))
+	{
+		if(it->path().extension() != THUMBNAIL_EXTENSION)
+			continue;
+
+		boost::system::error_code entryEc;
+		Entry entry;
+		entry.bytes = (uint64_t)fs::file_size(it->path(), entryEc);
+		entry.lastUse = (int64_t)fs::last_write_time(it->path(), entryEc);
+		if(entryEc)
+			continue;
+
+		mIndex[it->path().filename().string()] = entry;
+		mTotalBytes += entry.bytes;
+	}
+
+	LOG(LogInfo) << "Thumbnail cache: " << mIndex.size() << " images, " << (mTotalBytes / 1024 / 1024) << " MB";
+}
+
+void ThumbnailCache::trim(uint64_t maxBytes)
+{
+	if(mTotalBytes <= maxBytes)
+		return;
+
+	std::vector< std::pair<int64_t, std::string> > byAge;
+	byAge.reserve(mIndex.size());
+	for(auto it = mIndex.begin(); it != mIndex.end(); it++)
+		byAge.push_back(std::make_pair(it->second.lastUse, it->first));
+	std::sort(byAge.begin(), byAge.end());
+
+	for(auto it = byAge.begin(); it != byAge.end() && mTotalBytes > maxBytes; it++)
+	{
+		boost::system::error_code ec;
+		fs::remove(mDirectory + "/" + it->second, ec);
+
+		auto found = mIndex.find(it->second);
+		mTotalBytes -= found->second.bytes;
+		mIndex.erase(found);
+	}
+}
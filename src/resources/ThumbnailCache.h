@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <atomic>
+#include <stdint.h>
+#include "../BinaryIO.h"
+#include "../ImageIO.h"
+
+//Decoded, scaled down game images on disk (in ~/.emulationstation/thumbnails/), so an image seen in an earlier run
+//doesn't have to be decoded again - the pixels are mapped straight from the file and uploaded.
+//Images are stored packed in the format they're uploaded with (see TextureResource::packForUpload()). Entries are keyed
+//by the image's path, file size and modification time, the size it was decoded for and the texture format settings,
+//so changing the image, the theme or the settings just means new entries. Once the cache takes up more than the
+//"ThumbnailCacheSize" setting (in MB, 0 = off), the least recently used entries are deleted.
+//Every method is safe to call from several threads.
+class ThumbnailCache
+{
+public:
+	//A cached image, mapped into memory. Keep it until its pixels are uploaded.
+	class Thumbnail
+	{
+	public:
+		const unsigned char* getPixels() const { return (const unsigned char*)mFile.data() + mPixelOffset; }
+		ImageIO::PixelFormat getFormat() const { return mFormat; }
+		size_t getWidth() const { return mWidth; }
+		size_t getHeight() const { return mHeight; }
+		size_t getSourceWidth() const { return mSourceWidth; } //of the image in the file it was decoded from
+		size_t getSourceHeight() const { return mSourceHeight; }
+
+	private:
+		friend class ThumbnailCache;
+
+		MappedFile mFile;
+		size_t mPixelOffset;
+		ImageIO::PixelFormat mFormat;
+		size_t mWidth;
+		size_t mHeight;
+		size_t mSourceWidth;
+		size_t mSourceHeight;
+	};
+
+	static ThumbnailCache* getInstance();
+
+	//Returns the image at path decoded for targetWidth x targetHeight (see ImageIO::loadFromMemoryRGBA32()), or NULL
+	//if it isn't cached or the file changed since.
+	std::shared_ptr<Thumbnail> get(const std::string& path, size_t targetWidth, size_t targetHeight);
+
+	//Stores the image at path, decoded for targetWidth x targetHeight. Images that weren't scaled down aren't worth
+	//the disk space and are skipped.
+	void put(const std::string& path, size_t targetWidth, size_t targetHeight, const unsigned char* pixels, ImageIO::PixelFormat format,
+		size_t width, size_t height, size_t sourceWidth, size_t sourceHeight);
+
+	//Decodes path for targetWidth x targetHeight and stores it, unless it's cached already. Returns true if it was added.
+	bool build(const std::string& path, size_t targetWidth, size_t targetHeight);
+
+	unsigned int getHits() const { return mHits; }
+	unsigned int getMisses() const { return mMisses; }
+
+private:
+	ThumbnailCache();
+
+	struct Entry
+	{
+		uint64_t bytes;
+		int64_t lastUse; //seconds, the modification time of the file
+	};
+
+	//the key of path for targetWidth x targetHeight, empty if path can't be stat'd (or is an embedded resource)
+	static std::string getKey(const std::string& path, size_t targetWidth, size_t targetHeight);
+	static std::string getFileName(const std::string& key);
+	bool isEnabled() const;
+
+	//reads the size and last use of every entry on disk, once. mMutex must be held.
+	void loadIndex();
+	//deletes the least recently used entries until at most maxBytes are left. mMutex must be held.
+	void trim(uint64_t maxBytes);
+
+	static ThumbnailCache* sInstance;
+
+	const std::string mDirectory;
+
+	std::mutex mMutex;
+	bool mIndexLoaded;
+	std::unordered_map<std::string, Entry> mIndex; //file name -> entry
+	uint64_t mTotalBytes;
+	std::set<std::string> mWriting; //file names being written right now
+
+	std::atomic<unsigned int> mHits;
+	std::atomic<unsigned int> mMisses;
+};